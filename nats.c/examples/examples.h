@@ -44,6 +44,7 @@ int64_t          start   = 0;
 volatile int64_t elapsed = 0;
 bool             print   = false;
 int64_t          timeout = 10000; // 10 seconds.
+int64_t          busyPoll = 0;
 
 natsOptions      *opts   = NULL;
 
@@ -147,6 +148,7 @@ printUsageAndExit(const char *progName, const char *usage)
 "-subj          subject (default is 'foo')\n" \
 "-print         for consumers, print received messages (default is false)\n" \
 "-wd            write deadline in milliseconds\n" \
+"-busypoll      time (in microseconds) to spin before waiting for data\n" \
                 "%s\n",
                 progName, usage);
 
@@ -381,6 +383,14 @@ parseArgs(int argc, char **argv, const char *usage)
 
             s = natsOptions_SetWriteDeadline(opts, atol(argv[++i]));
         }
+        else if (strcasecmp(argv[i], "-busypoll") == 0)
+        {
+            if (i + 1 == argc)
+                printUsageAndExit(argv[0], usage);
+
+            busyPoll = atol(argv[++i]);
+            s = natsOptions_SetBusyPoll(opts, busyPoll, 0);
+        }
         else
         {
             printf("Unknown option: '%s'\n", argv[i]);
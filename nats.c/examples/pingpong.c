@@ -0,0 +1,231 @@
+// Copyright 2020 The NATS Authors
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "examples.h"
+
+static const char *usage = ""\
+"-count         number of round trips for each delivery mode\n" \
+"-txt           text to send (default is 'hello')\n" \
+"-timeout       maximum time (in milliseconds) for each delivery mode\n" \
+"\nEach delivery mode is measured without, then with busy polling\n" \
+"(see -busypoll, default is 100us, 0 to skip).\n";
+
+#define MODE_OWN_THREAD (0)
+#define MODE_LIB_POOL   (1)
+#define MODE_INLINE     (2)
+
+static const char *modeNames[] = {
+    "Own thread",
+    "Library pool",
+    "Inline",
+};
+
+static const char  *pongSubj = "pingpong.pong";
+
+static int64_t              *rtts      = NULL;
+static int64_t              sentAt     = 0;
+static volatile bool        done       = false;
+static volatile natsStatus  pingStatus = NATS_OK;
+
+static void
+onPing(natsConnection *nc, natsSubscription *sub, natsMsg *msg, void *closure)
+{
+    natsConnection_Publish(nc, natsMsg_GetReply(msg),
+                           natsMsg_GetData(msg), natsMsg_GetDataLength(msg));
+
+    natsMsg_Destroy(msg);
+}
+
+static natsStatus
+sendPing(natsConnection *nc)
+{
+    sentAt = nats_NowInNanoSeconds();
+
+    return natsConnection_PublishRequestString(nc, subj, pongSubj, txt);
+}
+
+// Records the round trip time and sends the next ping, so that there is
+// only one message in flight.
+static void
+onPong(natsConnection *nc, natsSubscription *sub, natsMsg *msg, void *closure)
+{
+    natsStatus s = NATS_OK;
+
+    rtts[count] = nats_NowInNanoSeconds() - sentAt;
+
+    natsMsg_Destroy(msg);
+
+    if (++count < total)
+        s = sendPing(nc);
+
+    // We should be using a mutex to protect those variables since
+    // they are used from the subscription's delivery and the main
+    // threads. For demo purposes, this is fine.
+    if ((count == total) || (s != NATS_OK))
+    {
+        pingStatus = s;
+        done       = true;
+    }
+}
+
+static natsStatus
+subscribe(natsSubscription **sub, natsConnection *nc, const char *subject,
+          natsMsgHandler cb, int mode)
+{
+    if (mode == MODE_INLINE)
+        return natsConnection_SubscribeInline(sub, nc, subject, cb, NULL);
+
+    return natsConnection_Subscribe(sub, nc, subject, cb, NULL);
+}
+
+static int
+cmpRtt(const void *a, const void *b)
+{
+    int64_t ra = *((const int64_t*) a);
+    int64_t rb = *((const int64_t*) b);
+
+    return (ra < rb ? -1 : (ra > rb ? 1 : 0));
+}
+
+static void
+printLatency(const char *name, int64_t spin)
+{
+    char    label[64];
+    int64_t sum = 0;
+    int64_t i;
+
+    qsort(rtts, (size_t) total, sizeof(int64_t), cmpRtt);
+
+    for (i=0; i<total; i++)
+        sum += rtts[i];
+
+    if (spin > 0)
+        snprintf(label, sizeof(label), "%s, spin %" PRId64 "us", name, spin);
+    else
+        snprintf(label, sizeof(label), "%s", name);
+
+    printf("%-26s avg=%7.2fus  p50=%7.2fus  p90=%7.2fus  p99=%7.2fus  p99.9=%7.2fus  max=%8.2fus\n",
+           label,
+           (double) sum / (double) total / 1000.0,
+           (double) rtts[total * 50 / 100] / 1000.0,
+           (double) rtts[total * 90 / 100] / 1000.0,
+           (double) rtts[total * 99 / 100] / 1000.0,
+           (double) rtts[total * 999 / 1000] / 1000.0,
+           (double) rtts[total - 1] / 1000.0);
+}
+
+static natsStatus
+run(int mode, int64_t spin)
+{
+    natsConnection      *pingConn = NULL;
+    natsConnection      *pongConn = NULL;
+    natsSubscription    *pingSub  = NULL;
+    natsSubscription    *pongSub  = NULL;
+    natsStatus          s;
+
+    count      = 0;
+    done       = false;
+    pingStatus = NATS_OK;
+
+    s = natsOptions_UseGlobalMessageDelivery(opts, (mode == MODE_LIB_POOL));
+    if (s == NATS_OK)
+        s = natsOptions_SetBusyPoll(opts, spin, 0);
+    if (s == NATS_OK)
+        s = natsConnection_Connect(&pongConn, opts);
+    if (s == NATS_OK)
+        s = natsConnection_Connect(&pingConn, opts);
+    if (s == NATS_OK)
+        s = subscribe(&pingSub, pongConn, subj, onPing, mode);
+    if (s == NATS_OK)
+        s = subscribe(&pongSub, pingConn, pongSubj, onPong, mode);
+    if (s == NATS_OK)
+        s = natsConnection_Flush(pongConn);
+    if (s == NATS_OK)
+        s = natsConnection_Flush(pingConn);
+    if (s == NATS_OK)
+    {
+        start = nats_Now();
+        s = sendPing(pingConn);
+    }
+
+    while ((s == NATS_OK) && !done)
+    {
+        if (nats_Now() - start >= timeout)
+            s = NATS_TIMEOUT;
+        else
+            nats_Sleep(100);
+    }
+    if (s == NATS_OK)
+        s = pingStatus;
+
+    if (s == NATS_OK)
+        printLatency(modeNames[mode], spin);
+
+    natsSubscription_Destroy(pongSub);
+    natsSubscription_Destroy(pingSub);
+    natsConnection_Destroy(pingConn);
+    natsConnection_Destroy(pongConn);
+
+    return s;
+}
+
+int main(int argc, char **argv)
+{
+    natsStatus  s;
+    int         mode;
+
+    // A round trip is much longer than sending a message.
+    total    = 100000;
+    busyPoll = 100;
+
+    opts = parseArgs(argc, argv, usage);
+
+    // Send pings and pongs right away instead of buffering them.
+    s = natsOptions_SetSendAsap(opts, true);
+    if ((s == NATS_OK) && (total <= 0))
+        s = NATS_INVALID_ARG;
+    if (s == NATS_OK)
+    {
+        rtts = (int64_t*) calloc((size_t) total, sizeof(int64_t));
+        if (rtts == NULL)
+            s = NATS_NO_MEMORY;
+    }
+
+    if (s == NATS_OK)
+        printf("Measuring %" PRId64 " round trips on '%s' for each delivery mode\n\n",
+               total, subj);
+
+    for (mode = MODE_OWN_THREAD; (s == NATS_OK) && (mode <= MODE_INLINE); mode++)
+        s = run(mode, 0);
+
+    if ((s == NATS_OK) && (busyPoll > 0))
+        printf("\n");
+
+    for (mode = MODE_OWN_THREAD; (s == NATS_OK) && (busyPoll > 0) && (mode <= MODE_INLINE); mode++)
+        s = run(mode, busyPoll);
+
+    if (s != NATS_OK)
+    {
+        printf("Error: %d - %s\n", s, natsStatus_GetText(s));
+        nats_PrintLastErrorStack(stderr);
+    }
+
+    // Destroy all our objects to avoid report of memory leak
+    free(rtts);
+    natsOptions_Destroy(opts);
+
+    // To silence reports of memory still in used with valgrind
+    nats_Close();
+
+    return 0;
+}
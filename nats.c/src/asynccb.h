@@ -24,6 +24,8 @@ typedef enum
     ASYNC_ERROR,
     ASYNC_DISCOVERED_SERVERS,
     ASYNC_CONNECTED,
+    ASYNC_OUTBOUND_HIGH,
+    ASYNC_OUTBOUND_LOW,
 
 #if defined(NATS_HAS_STREAMING)
     ASYNC_STAN_CONN_LOST
@@ -182,6 +182,16 @@ natsSock_ConnectTcp(natsSockCtx *ctx, const char *phost, int port)
             }
 
             s = natsSock_SetCommonTcpOptions(ctx->fd);
+#if defined(SO_BUSY_POLL)
+            if ((s == NATS_OK)
+                && (ctx->sockBusyPoll > 0)
+                && (setsockopt(ctx->fd, SOL_SOCKET, SO_BUSY_POLL,
+                               (const char*) &(ctx->sockBusyPoll), sizeof(int)) == -1))
+            {
+                s = nats_setError(NATS_SYS_ERROR, "setsockopt SO_BUSY_POLL error: %d",
+                                  NATS_SOCK_GET_ERROR);
+            }
+#endif
             if (s == NATS_OK)
                 break;
         }
@@ -298,6 +308,8 @@ natsSock_Read(natsSockCtx *ctx, char *buffer, size_t maxBufferSize, int *n)
     natsStatus  s         = NATS_OK;
     int         readBytes = 0;
     bool        needRead  = true;
+    int64_t     spinEnd   = 0;
+    int64_t     now;
 
     while (needRead)
     {
@@ -352,6 +364,21 @@ natsSock_Read(natsSockCtx *ctx, char *buffer, size_t maxBufferSize, int *n)
                 return NATS_OK;
             }
 
+            // With busy polling, try again until the budget is exhausted
+            // instead of having the thread woken up when data arrives.
+            if (ctx->busyPoll > 0)
+            {
+                now = nats_monotonicNowInNanoSeconds();
+                if (spinEnd == 0)
+                    spinEnd = now + ctx->busyPoll;
+
+                if (now < spinEnd)
+                {
+                    nats_cpuPause();
+                    continue;
+                }
+            }
+
             // For non-blocking sockets, if the read would block, we need to
             // wait up to the deadline.
             s = natsSock_WaitReady(WAIT_FOR_READ, ctx);
@@ -487,6 +514,83 @@ natsSock_WriteFully(natsSockCtx *ctx, const char *data, int len)
     return NATS_UPDATE_ERR_STACK(s);
 }
 
+natsStatus
+natsSock_WriteV(natsSockCtx *ctx, natsIOVec *iov, int iovcnt)
+{
+    natsStatus  s     = NATS_OK;
+    int         bytes = 0;
+
+#if defined(NATS_HAS_TLS)
+    // There is no gather write with SSL, write segments one after the other.
+    if (ctx->ssl != NULL)
+    {
+        int i;
+
+        for (i=0; (s == NATS_OK) && (i<iovcnt); i++)
+            s = natsSock_WriteFully(ctx, (const char*) iov[i].iov_base,
+                                    (int) iov[i].iov_len);
+
+        return NATS_UPDATE_ERR_STACK(s);
+    }
+#endif
+
+    while (s == NATS_OK)
+    {
+        // Skip segments that have been fully sent (or are empty).
+        while ((iovcnt > 0) && (iov->iov_len == 0))
+        {
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt == 0)
+            return NATS_OK;
+
+        bytes = natsSock_SendV(ctx->fd, iov, iovcnt);
+        if (bytes == 0)
+        {
+            s = nats_setDefaultError(NATS_CONNECTION_CLOSED);
+        }
+        else if (bytes == NATS_SOCK_ERROR)
+        {
+            if (NATS_SOCK_GET_ERROR != NATS_SOCK_WOULD_BLOCK)
+                s = nats_setError(NATS_IO_ERROR, "sendmsg error: %d",
+                                  NATS_SOCK_GET_ERROR);
+            else
+                s = natsSock_WaitReady(WAIT_FOR_WRITE, ctx);
+        }
+        else
+        {
+            // Account for what has been sent, possibly part of a segment.
+            while (bytes > 0)
+            {
+                if ((size_t) bytes >= iov->iov_len)
+                {
+                    bytes -= (int) iov->iov_len;
+                    iov->iov_len = 0;
+                    iov++;
+                    iovcnt--;
+                }
+                else
+                {
+                    iov->iov_base = (char*) iov->iov_base + bytes;
+                    iov->iov_len -= (size_t) bytes;
+                    bytes = 0;
+                }
+            }
+        }
+    }
+
+    // Like natsSock_WriteFully(), on write deadline, shutdown the
+    // socket to trigger a possible reconnect.
+    if (s == NATS_TIMEOUT)
+    {
+        natsSock_Shutdown(ctx->fd);
+        ctx->fdActive = false;
+    }
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
 void
 natsSock_ClearDeadline(natsSockCtx *ctx)
 {
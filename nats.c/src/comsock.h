@@ -69,6 +69,18 @@ natsSock_Write(natsSockCtx *ctx, const char *data, int len, int *n);
 natsStatus
 natsSock_WriteFully(natsSockCtx *ctx, const char *data, int len);
 
+// Writes all the segments described by 'iov' to the socket, using gather
+// writes when possible (that is, when not using TLS). Like natsSock_WriteFully(),
+// does not return until everything has been written, unless an error occurs.
+// Note that the content of 'iov' is modified to track partial writes.
+natsStatus
+natsSock_WriteV(natsSockCtx *ctx, natsIOVec *iov, int iovcnt);
+
+// Platform specific gather write of up to NATS_SOCK_IOV_MAX segments.
+// Returns the number of bytes sent, or NATS_SOCK_ERROR.
+int
+natsSock_SendV(natsSock fd, natsIOVec *iov, int iovcnt);
+
 natsStatus
 natsSock_Flush(natsSock fd);
 
@@ -35,6 +35,11 @@
 #include "crypto.h"
 
 #define DEFAULT_SCRATCH_SIZE    (512)
+
+// Size of the chunks of the reconnect pending buffer, and maximum
+// number of chunks sent with a single gather write when replaying it.
+#define PENDING_CHUNK_SIZE      (32*1024)
+#define PENDING_IOV_MAX         (64)
 #define MAX_INFO_MESSAGE_SIZE   (32768)
 
 #define NATS_EVENT_ACTION_ADD       (true)
@@ -172,24 +177,90 @@ _clearServerInfo(natsServerInfo *si)
     memset(si, 0, sizeof(natsServerInfo));
 }
 
+static void
+_freePubStages(natsConnection *nc)
+{
+    natsPubStage    *stage;
+    int             i;
+
+    if (nc->pubStages == NULL)
+        return;
+
+    for (i=0; i<NATS_PUB_STAGES_COUNT; i++)
+    {
+        stage = &(nc->pubStages[i]);
+
+        natsBuf_Destroy(stage->buf);
+        natsBuf_Destroy(stage->spare);
+        natsMutex_Destroy(stage->mu);
+    }
+    NATS_FREE(nc->pubStages);
+    nc->pubStages = NULL;
+}
+
+static natsStatus
+_createPubStages(natsConnection *nc)
+{
+    natsStatus  s = NATS_OK;
+    int         i;
+
+    nc->pubStages = (natsPubStage*) NATS_CALLOC(NATS_PUB_STAGES_COUNT, sizeof(natsPubStage));
+    if (nc->pubStages == NULL)
+        return nats_setDefaultError(NATS_NO_MEMORY);
+
+    // The stage buffers themselves are created on first use.
+    for (i=0; (s == NATS_OK) && (i<NATS_PUB_STAGES_COUNT); i++)
+        s = natsMutex_Create(&(nc->pubStages[i].mu));
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
+// Enables or disables the use of the publish staging areas. When disabled,
+// publish calls go through the regular (locked) path.
+static void
+_setPubStagesOpen(natsConnection *nc, bool open)
+{
+    natsPubStage    *stage;
+    int             i;
+
+    if (nc->pubStages == NULL)
+        return;
+
+    for (i=0; i<NATS_PUB_STAGES_COUNT; i++)
+    {
+        stage = &(nc->pubStages[i]);
+
+        natsMutex_Lock(stage->mu);
+        stage->open       = open;
+        stage->maxPayload = nc->info.maxPayload;
+        natsMutex_Unlock(stage->mu);
+    }
+}
+
 static void
 _freeConn(natsConnection *nc)
 {
     if (nc == NULL)
         return;
 
+    _freePubStages(nc);
+
     natsTimer_Destroy(nc->ptmr);
-    natsBuf_Destroy(nc->pending);
+    natsSegBuf_Destroy(nc->pending);
     natsBuf_Destroy(nc->scratch);
     natsBuf_Destroy(nc->bw);
+    natsBuf_Destroy(nc->bwBack);
     natsSrvPool_Destroy(nc->srvPool);
     _clearServerInfo(&(nc->info));
     natsCondition_Destroy(nc->flusherCond);
+    natsCondition_Destroy(nc->outboundCond);
     natsCondition_Destroy(nc->pongs.cond);
     natsParser_Destroy(nc->ps);
+    natsMsgPool_Release(nc->msgPool);
     natsThread_Destroy(nc->readLoopThread);
     natsThread_Destroy(nc->flusherThread);
     natsHash_Destroy(nc->subs);
+    natsSubTable_Destroy(nc->subTable);
     natsOptions_Destroy(nc->opts);
     if (nc->sockCtx.ssl != NULL)
         SSL_free(nc->sockCtx.ssl);
@@ -201,6 +272,7 @@ _freeConn(natsConnection *nc)
     natsCondition_Destroy(nc->reconnectCond);
     natsMutex_Destroy(nc->subsMu);
     natsTimer_Destroy(nc->drainTimer);
+    natsMutex_Destroy(nc->writeMu);
     natsMutex_Destroy(nc->mu);
 
     NATS_FREE(nc);
@@ -270,7 +342,7 @@ natsConn_bufferFlush(natsConnection *nc)
 
     if (nc->usePending)
     {
-        s = natsBuf_Append(nc->pending, natsBuf_Data(nc->bw), bufLen);
+        s = natsSegBuf_Append(nc->pending, natsBuf_Data(nc->bw), bufLen);
     }
     else if (nc->sockCtx.useEventLoop)
     {
@@ -287,10 +359,18 @@ natsConn_bufferFlush(natsConnection *nc)
     }
     else
     {
+        natsMutex_Lock(nc->writeMu);
         s = natsSock_WriteFully(&(nc->sockCtx), natsBuf_Data(nc->bw), bufLen);
+        natsMutex_Unlock(nc->writeMu);
+        if (s == NATS_OK)
+        {
+            nc->stats.flushes++;
+            nc->stats.flushedBytes += (uint64_t) bufLen;
+        }
     }
 
     natsBuf_Reset(nc->bw);
+    natsConn_outboundChanged(nc);
 
     return NATS_UPDATE_ERR_STACK(s);
 }
@@ -299,14 +379,12 @@ natsStatus
 natsConn_bufferWrite(natsConnection *nc, const char *buffer, int len)
 {
     natsStatus  s = NATS_OK;
-    int         offset = 0;
-    int         avail  = 0;
 
     if (len <= 0)
         return NATS_OK;
 
     if (nc->usePending)
-        return natsBuf_Append(nc->pending, buffer, len);
+        return natsSegBuf_Append(nc->pending, buffer, len);
 
     if (nc->sockCtx.useEventLoop)
     {
@@ -325,42 +403,44 @@ natsConn_bufferWrite(natsConnection *nc, const char *buffer, int len)
         return NATS_UPDATE_ERR_STACK(s);
     }
 
-    // If we have more data that can fit..
-    while ((s == NATS_OK) && (len > natsBuf_Available(nc->bw)))
+    // If we have more data that can fit, write to the socket, unless the
+    // flusher thread is used. Since it writes the buffer without holding
+    // the connection lock, the buffer grows instead. The flusher
+    // is then woken up (see _getFlusherDelay()), and publish calls wait for
+    // it to swap the buffers (see natsConn_reserveOutbound()).
+    if ((len > natsBuf_Available(nc->bw)) && (nc->bwBack == NULL))
     {
-        // If there is nothing in the buffer...
-        if (natsBuf_Len(nc->bw) == 0)
-        {
-            // Do a single socket write to avoid a copy
-            s = natsSock_WriteFully(&(nc->sockCtx), buffer + offset, len);
+        natsIOVec       iov[2];
+        int             iovcnt = 0;
 
-            // We are done
-            return NATS_UPDATE_ERR_STACK(s);
+        // Send what is in the buffer and the data with a single gather
+        // write, so that the data is never copied into the buffer.
+        if (natsBuf_Len(nc->bw) > 0)
+        {
+            iov[iovcnt].iov_base = natsBuf_Data(nc->bw);
+            iov[iovcnt].iov_len  = (size_t) natsBuf_Len(nc->bw);
+            iovcnt++;
         }
+        iov[iovcnt].iov_base = (void*) buffer;
+        iov[iovcnt].iov_len  = (size_t) len;
+        iovcnt++;
 
-        // We already have data in the buffer, check how many more bytes
-        // can we fit
-        avail = natsBuf_Available(nc->bw);
-
-        // Append that much bytes
-        s = natsBuf_Append(nc->bw, buffer + offset, avail);
-
-        // Flush the buffer
-        if (s == NATS_OK)
-            s = natsConn_bufferFlush(nc);
-
-        // If success, then decrement what's left to send and update the
-        // offset.
+        natsMutex_Lock(nc->writeMu);
+        s = natsSock_WriteV(&(nc->sockCtx), iov, iovcnt);
+        natsMutex_Unlock(nc->writeMu);
         if (s == NATS_OK)
         {
-            len    -= avail;
-            offset += avail;
+            nc->stats.flushes++;
+            nc->stats.flushedBytes += (uint64_t) (natsBuf_Len(nc->bw) + len);
         }
+
+        natsBuf_Reset(nc->bw);
+        natsConn_outboundChanged(nc);
+
+        return NATS_UPDATE_ERR_STACK(s);
     }
 
-    // If there is data left, the buffer can now hold this data.
-    if ((s == NATS_OK) && (len > 0))
-        s = natsBuf_Append(nc->bw, buffer + offset, len);
+    s = natsBuf_Append(nc->bw, buffer, len);
 
     return NATS_UPDATE_ERR_STACK(s);
 }
@@ -380,7 +460,7 @@ _createConn(natsConnection *nc)
 {
     natsStatus  s = NATS_OK;
 
-    nc->cur->lastAttempt = nats_Now();
+    nc->cur->lastAttempt = nats_monotonicNow();
 
     // Sets a deadline for the connect process (not just the low level
     // tcp connect. The deadline will be removed when we have received
@@ -390,6 +470,9 @@ _createConn(natsConnection *nc)
     // Set the IP resolution order
     nc->sockCtx.orderIP = nc->opts->orderIP;
 
+    nc->sockCtx.busyPoll     = nc->opts->busyPoll * 1000;
+    nc->sockCtx.sockBusyPoll = nc->opts->sockBusyPoll;
+
     s = natsSock_ConnectTcp(&(nc->sockCtx), nc->cur->url->host, nc->cur->url->port);
     if (s == NATS_OK)
         nc->sockCtx.fdActive = true;
@@ -405,6 +488,15 @@ _createConn(natsConnection *nc)
         else
             natsBuf_Reset(nc->bw);
 
+        nc->bwBackStatus = NATS_OK;
+
+        // The back buffer is only needed if the flusher thread is used.
+        if ((ls == NATS_OK) && (nc->bwBack == NULL)
+            && !(nc->opts->sendAsap) && (nc->opts->evLoop == NULL))
+        {
+            ls = natsBuf_Create(&(nc->bwBack), nc->opts->ioBufSize);
+        }
+
         if (s == NATS_OK)
             s = ls;
     }
@@ -1022,7 +1114,10 @@ _sendUnsubProto(natsConnection *nc, int64_t subId, int max)
         s = nats_setDefaultError(NATS_NO_MEMORY);
     else
     {
-        s = natsConn_bufferWriteString(nc, proto);
+        // Messages staged before the unsubscribe need to be sent first.
+        s = natsConn_drainPubStages(nc);
+        if (s == NATS_OK)
+            s = natsConn_bufferWriteString(nc, proto);
         NATS_FREE(proto);
     }
 
@@ -1113,27 +1208,70 @@ _resendSubscriptions(natsConnection *nc)
     return s;
 }
 
+// Sends the content of the pending buffer with gather writes of up to
+// PENDING_IOV_MAX chunks. Chunks are released as soon as they have been
+// sent, and the progress is reflected in the outbound watermarks.
+// The connection lock is released during each write. Since the pending
+// buffer is still in use, anything published in the meantime is queued
+// behind the data being replayed.
+// Connection lock is held on entry and on return.
 static natsStatus
 _flushReconnectPendingItems(natsConnection *nc)
 {
-    natsStatus s = NATS_OK;
+    natsStatus      s      = NATS_OK;
+    natsIOVec       iov[PENDING_IOV_MAX];
+    int             iovcnt = 0;
+    int64_t         bytes  = 0;
 
     if (nc->pending == NULL)
         return NATS_OK;
 
-    if (natsBuf_Len(nc->pending) > 0)
+    // Send the subscriptions first.
+    s = natsConn_bufferFlush(nc);
+
+    // From now on, publish calls go to the pending buffer again.
+    nc->usePending = true;
+    nc->replaying  = true;
+
+    while ((s == NATS_OK) && (natsSegBuf_Len(nc->pending) > 0))
     {
-        // Flush pending buffer
-        s = natsConn_bufferWrite(nc, natsBuf_Data(nc->pending),
-                                 natsBuf_Len(nc->pending));
+        iovcnt = natsSegBuf_GetIOV(nc->pending, iov, PENDING_IOV_MAX, &bytes);
+
+        SET_WRITE_DEADLINE(nc);
+
+        // Publish calls only append to the pending buffer, and a failed
+        // one only truncates what it has appended, so the data referenced
+        // by 'iov' can be written without the connection lock. Closing
+        // the socket requires the write lock.
+        natsMutex_Lock(nc->writeMu);
+        natsConn_Unlock(nc);
 
-        // Regardless of outcome, we must clear the pending buffer
-        // here to avoid duplicates (if the flush were to fail
-        // with some messages/partial messages being sent).
-        natsBuf_Reset(nc->pending);
+        s = natsSock_WriteV(&(nc->sockCtx), iov, iovcnt);
+
+        natsMutex_Unlock(nc->writeMu);
+        natsConn_Lock(nc);
+
+        if ((s == NATS_OK) && natsConn_isClosed(nc))
+            s = nats_setError(NATS_CONNECTION_CLOSED, "%s", "connection has been closed/destroyed while reconnecting");
+
+        if (s == NATS_OK)
+        {
+            nc->stats.flushes++;
+            nc->stats.flushedBytes += (uint64_t) bytes;
+
+            natsSegBuf_Consume(nc->pending, bytes);
+            natsConn_outboundChanged(nc);
+        }
     }
 
-    return s;
+    nc->replaying = false;
+
+    // Regardless of outcome, we must clear the pending buffer
+    // here to avoid duplicates (if the flush were to fail
+    // with some messages/partial messages being sent).
+    natsSegBuf_Reset(nc->pending);
+
+    return NATS_UPDATE_ERR_STACK(s);
 }
 
 static void
@@ -1471,7 +1609,7 @@ _doReconnect(void *arg)
         // Sleep appropriate amount of time before the
         // connection attempt if connecting to same server
         // we just got disconnected from..
-        if (((elapsed = nats_Now() - nc->cur->lastAttempt)) < nc->opts->reconnectWait)
+        if (((elapsed = nats_monotonicNow() - nc->cur->lastAttempt)) < nc->opts->reconnectWait)
             sleepTime = (nc->opts->reconnectWait - elapsed);
 
         if (sleepTime > 0)
@@ -1547,8 +1685,10 @@ _doReconnect(void *arg)
 
             // Close the socket since we were connected, but a problem occurred.
             // (not doing this would cause an FD leak)
+            natsMutex_Lock(nc->writeMu);
             natsSock_Close(nc->sockCtx.fd);
             nc->sockCtx.fd = NATS_SOCK_INVALID;
+            natsMutex_Unlock(nc->writeMu);
 
             // We need to re-activate the use of pending since we
             // may go back to sleep and release the lock
@@ -1577,10 +1717,15 @@ _doReconnect(void *arg)
 
         // At this point we know that we don't need the pending buffer
         // anymore. Destroy now.
-        natsBuf_Destroy(nc->pending);
+        natsSegBuf_Destroy(nc->pending);
         nc->pending     = NULL;
         nc->usePending  = false;
 
+        _setPubStagesOpen(nc, true);
+
+        // Publish calls blocked while reconnecting can now proceed.
+        natsConn_outboundChanged(nc);
+
         // Normally only set in _connect() but we need in case we allow
         // reconnect logic on initial connect failure.
         if (nc->initc)
@@ -1639,6 +1784,60 @@ _doReconnect(void *arg)
     natsConn_release(nc);
 }
 
+// Moves the messages published through the staging areas (when the
+// ConcurrentPublish option is set) to the outbound buffer. Since a thread
+// always uses the same staging area, and messages are moved while holding
+// the connection's lock, the order of messages published by a given thread
+// is preserved.
+// Connection lock is held on entry.
+natsStatus
+natsConn_drainPubStages(natsConnection *nc)
+{
+    natsStatus      s = NATS_OK;
+    natsPubStage    *stage;
+    natsBuffer      *buf;
+    uint64_t        msgs;
+    uint64_t        bytes;
+    int             i;
+
+    if (nc->pubStages == NULL)
+        return NATS_OK;
+
+    for (i=0; i<NATS_PUB_STAGES_COUNT; i++)
+    {
+        stage = &(nc->pubStages[i]);
+
+        natsMutex_Lock(stage->mu);
+        buf = stage->buf;
+        if ((buf == NULL) || (natsBuf_Len(buf) == 0))
+        {
+            natsMutex_Unlock(stage->mu);
+            continue;
+        }
+        // Swap the buffers so that publishers can keep on staging
+        // messages while we copy this content to the outbound buffer.
+        stage->buf   = stage->spare;
+        stage->spare = buf;
+        msgs         = stage->msgs;
+        bytes        = stage->bytes;
+        stage->msgs  = 0;
+        stage->bytes = 0;
+        natsMutex_Unlock(stage->mu);
+
+        // If an error occurred, we still empty the remaining stages.
+        if (s == NATS_OK)
+            s = natsConn_bufferWrite(nc, natsBuf_Data(buf), natsBuf_Len(buf));
+        if (s == NATS_OK)
+        {
+            nc->stats.outMsgs  += msgs;
+            nc->stats.outBytes += bytes;
+        }
+        natsBuf_Reset(buf);
+    }
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
 // If the connection has the option `sendAsap`, flushes the buffer
 // directly, otherwise, notifies the flusher thread that there is
 // pending data to send to the server.
@@ -1656,9 +1855,161 @@ natsConn_flushOrKickFlusher(natsConnection *nc)
         nc->flusherSignaled = true;
         natsCondition_Signal(nc->flusherCond);
     }
+    else if (nc->flusherWaiting && (natsBuf_Len(nc->bw) >= nc->flusherWakeBytes))
+    {
+        // Enough data has been buffered, no need for the flusher
+        // to wait any longer.
+        nc->flusherWaiting = false;
+        natsCondition_Signal(nc->flusherCond);
+    }
     return s;
 }
 
+// Returns the number of bytes buffered and not yet sent to the server.
+static int64_t
+_outboundBytes(natsConnection *nc)
+{
+    int64_t n = 0;
+
+    if (nc->bw != NULL)
+        n += natsBuf_Len(nc->bw);
+    if (nc->bwBack != NULL)
+        n += natsBuf_Len(nc->bwBack);
+    if (nc->pending != NULL)
+        n += natsSegBuf_Len(nc->pending);
+
+    return n;
+}
+
+// Returns true if the flusher thread is used and the front buffer is full.
+static bool
+_outboundBufferFull(natsConnection *nc)
+{
+    return ((nc->bwBack != NULL)
+            && !(nc->usePending)
+            && (natsBuf_Len(nc->bw) >= nc->opts->ioBufSize));
+}
+
+// Makes sure that `size` bytes can be buffered without exceeding the
+// outbound limit, applying the outbound policy otherwise. If the policy
+// is to drop the message, `drop` is set to `true` and NATS_OK returned.
+// Without a limit, waits for the flusher thread to swap the outbound
+// buffers if the front one is full, since it would otherwise grow for as
+// long as the socket is slow.
+// Connection lock is held on entry, but may be released while waiting
+// for room.
+natsStatus
+natsConn_reserveOutbound(natsConnection *nc, int size, bool *drop)
+{
+    natsOptions *opts = nc->opts;
+    natsStatus  s     = NATS_OK;
+    int64_t     outbound;
+
+    *drop = false;
+
+    if (opts->maxOutboundBytes <= 0)
+    {
+        while (_outboundBufferFull(nc))
+        {
+            natsConn_flushOrKickFlusher(nc);
+
+            nc->outboundWaiters++;
+            natsCondition_Wait(nc->outboundCond, nc->mu);
+            nc->outboundWaiters--;
+
+            // The write this call was waiting for has failed, for instance
+            // because of the write deadline.
+            if (nc->bwBackStatus != NATS_OK)
+                return nats_setDefaultError(nc->bwBackStatus);
+
+            // If the connection is closed while the flusher is writing,
+            // wait for the outcome of that write.
+            if (natsConn_isClosed(nc) && (natsBuf_Len(nc->bwBack) == 0))
+                return nats_setDefaultError(NATS_CONNECTION_CLOSED);
+        }
+        return NATS_OK;
+    }
+
+    for (;;)
+    {
+        outbound = _outboundBytes(nc);
+
+        // Always accept a message if nothing is buffered, otherwise
+        // a message bigger than the limit could never be sent.
+        if ((outbound == 0) || (outbound + size <= opts->maxOutboundBytes))
+            return NATS_OK;
+
+        if (opts->outboundPolicy == NATS_OUTBOUND_POLICY_DROP)
+        {
+            *drop = true;
+            return NATS_OK;
+        }
+        if (opts->outboundPolicy == NATS_OUTBOUND_POLICY_FAIL)
+        {
+            return nats_setError(NATS_OUTBOUND_LIMIT_REACHED,
+                                 "%" PRId64 " bytes already buffered, limit is %" PRId64,
+                                 outbound, opts->maxOutboundBytes);
+        }
+
+        // Make sure that the buffered data is going to be sent, then
+        // wait for the outbound to go down.
+        if (!natsConn_isReconnecting(nc))
+        {
+            s = natsConn_flushOrKickFlusher(nc);
+            if (s != NATS_OK)
+                return NATS_UPDATE_ERR_STACK(s);
+            if (nc->flusherWaiting)
+            {
+                nc->flusherWaiting = false;
+                natsCondition_Signal(nc->flusherCond);
+            }
+            if (_outboundBytes(nc) == 0)
+                continue;
+        }
+
+        nc->outboundWaiters++;
+        natsCondition_Wait(nc->outboundCond, nc->mu);
+        nc->outboundWaiters--;
+
+        if (natsConn_isClosed(nc))
+            return nats_setDefaultError(NATS_CONNECTION_CLOSED);
+    }
+}
+
+// Invokes the outbound watermark callbacks if the number of buffered
+// bytes has crossed one of the watermarks, and wakes up publish calls
+// waiting for room in the outbound buffers.
+// Connection lock is held on entry.
+void
+natsConn_outboundChanged(natsConnection *nc)
+{
+    natsOptions *opts = nc->opts;
+    int64_t     outbound;
+
+    if (nc->outboundWaiters > 0)
+        natsCondition_Broadcast(nc->outboundCond);
+
+    if ((opts->maxOutboundBytes <= 0) && (opts->outboundHighWatermark <= 0))
+        return;
+
+    outbound = _outboundBytes(nc);
+
+    if (!(nc->outboundHigh)
+        && (opts->outboundHighWatermark > 0)
+        && (outbound >= opts->outboundHighWatermark))
+    {
+        nc->outboundHigh = true;
+        if (opts->outboundHighCb != NULL)
+            natsAsyncCb_PostConnHandler(nc, ASYNC_OUTBOUND_HIGH);
+    }
+    else if (nc->outboundHigh && (outbound <= opts->outboundLowWatermark))
+    {
+        nc->outboundHigh = false;
+        if (opts->outboundLowCb != NULL)
+            natsAsyncCb_PostConnHandler(nc, ASYNC_OUTBOUND_LOW);
+    }
+}
+
 // reads a protocol one byte at a time.
 static natsStatus
 _readProto(natsConnection *nc, natsBuffer **proto)
@@ -1971,6 +2322,8 @@ _connect(natsConnection *nc)
 
     if ((retSts == NATS_OK) && (nc->status != NATS_CONN_STATUS_CONNECTED))
         s = nats_setDefaultError(NATS_NO_SERVER);
+    else if (nc->status == NATS_CONN_STATUS_CONNECTED)
+        _setPubStagesOpen(nc, true);
 
     nc->initc = false;
     natsConn_Unlock(nc);
@@ -2007,9 +2360,13 @@ _processOpError(natsConnection *nc, natsStatus s, bool initialConnect)
         if (nc->ptmr != NULL)
             natsTimer_Stop(nc->ptmr);
 
+        // Publish calls will now go to the pending buffer.
+        _setPubStagesOpen(nc, false);
+
         if (nc->sockCtx.fdActive)
         {
             SET_WRITE_DEADLINE(nc);
+            natsConn_drainPubStages(nc);
             natsConn_bufferFlush(nc);
 
             natsSock_Shutdown(nc->sockCtx.fd);
@@ -2030,7 +2387,7 @@ _processOpError(natsConnection *nc, natsStatus s, bool initialConnect)
 
         // Create the pending buffer to hold all write requests while we try
         // to reconnect.
-        ls = natsBuf_Create(&(nc->pending), nc->opts->reconnectBufSize);
+        ls = natsSegBuf_Create(&(nc->pending), PENDING_CHUNK_SIZE);
         if (ls == NATS_OK)
         {
             nc->usePending = true;
@@ -2073,22 +2430,63 @@ natsConn_clearSSL(natsConnection *nc)
     nc->sockCtx.ssl = NULL;
 }
 
+// Makes sure that the read loop has a slab with enough room to read into.
+// The current slab is read again from the start if no message references
+// it anymore, or after the data of the previous read if enough room is
+// left. Otherwise, it is released (messages keep it alive) and replaced
+// by a new one.
+static natsStatus
+_prepareReadSlab(natsMsgSlab **slab, int *pos, int size)
+{
+    natsStatus  s    = NATS_OK;
+    natsMsgSlab *cur = *slab;
+
+    if (cur != NULL)
+    {
+        if (nats_atomicGet(&(cur->refs)) == 1)
+        {
+            *pos = 0;
+            return NATS_OK;
+        }
+        if ((cur->size - *pos) > (size / 4))
+            return NATS_OK;
+
+        natsMsgSlab_Release(cur);
+        *slab = NULL;
+    }
+
+    s = natsMsgSlab_Create(slab, size);
+    if (s == NATS_OK)
+        *pos = 0;
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
 static void
 _readLoop(void  *arg)
 {
-    natsStatus  s = NATS_OK;
-    char        *buffer;
+    natsStatus  s        = NATS_OK;
+    char        *buffer  = NULL;
     int         n;
     int         bufSize;
+    bool        zeroCopy;
+    natsMsgSlab *slab    = NULL;
+    int         slabPos  = 0;
+    int         readSize;
 
     natsConnection *nc = (natsConnection*) arg;
 
     natsConn_Lock(nc);
 
-    bufSize = nc->opts->ioBufSize;
-    buffer = NATS_MALLOC(bufSize);
-    if (buffer == NULL)
-        s = nats_setDefaultError(NATS_NO_MEMORY);
+    bufSize  = nc->opts->ioBufSize;
+    zeroCopy = nc->opts->zeroCopyRecv;
+    if (!zeroCopy)
+    {
+        buffer = NATS_MALLOC(bufSize);
+        if (buffer == NULL)
+            s = nats_setDefaultError(NATS_NO_MEMORY);
+    }
+    readSize = bufSize;
 
     if (nc->sockCtx.ssl != NULL)
         nats_sslRegisterThreadForCleanup();
@@ -2098,19 +2496,36 @@ _readLoop(void  *arg)
     if (nc->ps == NULL)
         s = natsParser_Create(&(nc->ps));
 
+    // The pending buffer is still set while it is replayed, but then
+    // the socket is the new one.
     while ((s == NATS_OK)
            && !natsConn_isClosed(nc)
-           && !natsConn_isReconnecting(nc))
+           && (!natsConn_isReconnecting(nc) || nc->replaying))
     {
         natsConn_Unlock(nc);
 
         n = 0;
 
-        s = natsSock_Read(&(nc->sockCtx), buffer, bufSize, &n);
+        if (zeroCopy)
+        {
+            s = _prepareReadSlab(&slab, &slabPos, bufSize);
+            if (s == NATS_OK)
+            {
+                buffer   = slab->data + slabPos;
+                readSize = slab->size - slabPos;
+            }
+        }
+        if (s == NATS_OK)
+            s = natsSock_Read(&(nc->sockCtx), buffer, readSize, &n);
         if ((s == NATS_IO_ERROR) && (NATS_SOCK_GET_ERROR == NATS_SOCK_WOULD_BLOCK))
             s = NATS_OK;
         if ((s == NATS_OK) && (n > 0))
+        {
+            nc->ps->slab = slab;
             s = natsParser_Parse(nc, buffer, n);
+            nc->ps->slab = NULL;
+            slabPos += n;
+        }
 
         if (s != NATS_OK)
             _processOpError(nc, s, false);
@@ -2118,7 +2533,14 @@ _readLoop(void  *arg)
         natsConn_Lock(nc);
     }
 
-    NATS_FREE(buffer);
+    if (zeroCopy)
+        natsMsgSlab_Release(slab);
+    else
+        NATS_FREE(buffer);
+
+    // The flusher may be writing to the socket without holding the
+    // connection lock, so wait for that to complete before closing it.
+    natsMutex_Lock(nc->writeMu);
 
     natsSock_Close(nc->sockCtx.fd);
     nc->sockCtx.fd       = NATS_SOCK_INVALID;
@@ -2128,6 +2550,8 @@ _readLoop(void  *arg)
     if (nc->sockCtx.ssl != NULL)
         natsConn_clearSSL(nc);
 
+    natsMutex_Unlock(nc->writeMu);
+
     natsParser_Destroy(nc->ps);
     nc->ps = NULL;
 
@@ -2136,16 +2560,140 @@ _readLoop(void  *arg)
     natsConn_unlockAndRelease(nc);
 }
 
+// Swaps the outbound buffers and writes the content of the back buffer
+// without holding the connection lock, so that publishers can keep on
+// adding data to the front buffer. The write mutex is acquired before
+// releasing the connection lock, which guarantees that data written to
+// the socket under the connection lock (see natsConn_bufferFlush) can't
+// be sent ahead of the back buffer.
+// Connection lock is held on entry and on exit, but released during
+// the socket write.
+static natsStatus
+_flushBackBuffer(natsConnection *nc)
+{
+    natsStatus  s;
+    natsBuffer  *buf = nc->bw;
+
+    nc->bw      = nc->bwBack;
+    nc->bwBack  = buf;
+
+    nc->bwBackStatus = NATS_OK;
+
+    // Publish calls waiting for the front buffer to be swapped.
+    if (nc->outboundWaiters > 0)
+        natsCondition_Broadcast(nc->outboundCond);
+
+    natsMutex_Lock(nc->writeMu);
+    natsConn_Unlock(nc);
+
+    // Note that publishers may refresh the write deadline while we write,
+    // which can only extend the deadline for this write.
+    s = natsSock_WriteFully(&(nc->sockCtx), natsBuf_Data(buf), natsBuf_Len(buf));
+
+    natsMutex_Unlock(nc->writeMu);
+    natsConn_Lock(nc);
+
+    nc->bwBackStatus = s;
+
+    if (s == NATS_OK)
+    {
+        nc->stats.flushes++;
+        nc->stats.flushedBytes += (uint64_t) natsBuf_Len(buf);
+    }
+    natsBuf_Reset(buf);
+
+    // The buffer may have grown past its size while the back buffer was
+    // being written (see natsConn_bufferWrite()), do not keep that memory.
+    if (natsBuf_Capacity(buf) > nc->opts->ioBufSize)
+    {
+        natsBuffer *newBuf = NULL;
+
+        if (natsBuf_Create(&newBuf, nc->opts->ioBufSize) == NATS_OK)
+        {
+            natsBuf_Destroy(buf);
+            nc->bwBack = newBuf;
+        }
+    }
+    natsConn_outboundChanged(nc);
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
+// Returns how long (in milliseconds) the flusher should wait for more
+// data before flushing, based on the flush policy, and sets the number
+// of buffered bytes that should wake the flusher earlier.
+// The 'idle' boolean indicates if the flusher had to wait to be signaled,
+// as opposed to data having been buffered while it was busy flushing.
+// Connection lock is held on entry.
+static int64_t
+_getFlusherDelay(natsConnection *nc, bool idle)
+{
+    natsOptions *opts   = nc->opts;
+    int64_t     delay   = opts->flushMaxDelay;
+    int64_t     now;
+    int64_t     elapsed;
+    int64_t     needed;
+    int         target;
+
+    nc->flusherWakeBytes = opts->flushMinBytes;
+
+    if (opts->flushPolicy == NATS_FLUSH_POLICY_ADAPTIVE)
+    {
+        target = (opts->flushMinBytes > 0 ? opts->flushMinBytes : opts->ioBufSize);
+        nc->flusherWakeBytes = target;
+
+        now     = nats_monotonicNowInNanoSeconds();
+        elapsed = now - nc->flushRateTime;
+
+        // If the connection was idle, or if a single message was published
+        // since the last time (as with request/reply traffic), flush right
+        // away. Otherwise, update the estimated publish rate (a moving
+        // average, in bytes per ms).
+        if (idle
+            || (nc->flushRateTime == 0)
+            || ((nc->stats.outMsgs - nc->flushRateMsgs) <= 1))
+        {
+            nc->flushRate = 0;
+        }
+        else if (elapsed > 0)
+            nc->flushRate = (nc->flushRate + (int64_t) ((nc->stats.outBytes - nc->flushRateBytes) * 1000000 / (uint64_t) elapsed)) / 2;
+
+        nc->flushRateTime  = now;
+        nc->flushRateBytes = nc->stats.outBytes;
+        nc->flushRateMsgs  = nc->stats.outMsgs;
+
+        // Wait for the time needed to accumulate the target size.
+        if (nc->flushRate <= 0)
+            delay = 0;
+        else if ((needed = (int64_t) (target - natsBuf_Len(nc->bw))) <= 0)
+            delay = 0;
+        else if ((needed / nc->flushRate) < delay)
+            delay = needed / nc->flushRate;
+    }
+
+    // Do not wait once the buffer is full, since it would then grow.
+    if ((nc->flusherWakeBytes <= 0) || (nc->flusherWakeBytes > opts->ioBufSize))
+        nc->flusherWakeBytes = opts->ioBufSize;
+
+    if ((nc->flusherWakeBytes > 0) && (natsBuf_Len(nc->bw) >= nc->flusherWakeBytes))
+        delay = 0;
+
+    return delay;
+}
+
 static void
 _flusher(void *arg)
 {
     natsConnection  *nc  = (natsConnection*) arg;
     natsStatus      s;
+    int64_t         delay;
+    bool            idle;
 
     while (true)
     {
         natsConn_Lock(nc);
 
+        idle = !(nc->flusherSignaled);
         while (!(nc->flusherSignaled) && !(nc->flusherStop))
             natsCondition_Wait(nc->flusherCond, nc->mu);
 
@@ -2155,27 +2703,42 @@ _flusher(void *arg)
             break;
         }
 
-        //TODO: If we process the request right away, performance
-        //      will suffer when sending quickly very small messages.
-        //      The buffer is going to be always flushed, which
-        //      defeats the purpose of a write buffer.
-        //      We need to revisit this.
-
-        // Give a chance to accumulate more requests...
-        natsCondition_TimedWait(nc->flusherCond, nc->mu, 1);
+        // Give a chance to accumulate more requests, for as long as
+        // the flush policy says.
+        delay = _getFlusherDelay(nc, idle);
+        if (delay > 0)
+        {
+            nc->flusherWaiting = (nc->flusherWakeBytes > 0);
+            natsCondition_TimedWait(nc->flusherCond, nc->mu, delay);
+            nc->flusherWaiting = false;
+        }
 
         nc->flusherSignaled = false;
 
-        if (!_isConnected(nc) || natsConn_isClosed(nc) || natsConn_isReconnecting(nc))
+        // While the pending buffer is replayed, anything that would be
+        // flushed goes to the pending buffer.
+        if (natsConn_isClosed(nc)
+            || (!(nc->replaying) && (!_isConnected(nc) || natsConn_isReconnecting(nc))))
         {
             natsConn_Unlock(nc);
             break;
         }
 
+        if (nc->sockCtx.fdActive && (nc->pubStages != NULL))
+        {
+            SET_WRITE_DEADLINE(nc);
+            s = natsConn_drainPubStages(nc);
+            if ((s != NATS_OK) && (nc->err == NATS_OK))
+                nc->err = s;
+        }
+
         if (nc->sockCtx.fdActive && (natsBuf_Len(nc->bw) > 0))
         {
             SET_WRITE_DEADLINE(nc);
-            s = natsConn_bufferFlush(nc);
+            if (nc->sockCtx.useEventLoop || (nc->bwBack == NULL))
+                s = natsConn_bufferFlush(nc);
+            else
+                s = _flushBackBuffer(nc);
             if ((s != NATS_OK) && (nc->err == NATS_OK))
                 nc->err = s;
         }
@@ -2194,7 +2757,10 @@ _sendPing(natsConnection *nc, natsPong *pong)
     natsStatus  s     = NATS_OK;
 
     SET_WRITE_DEADLINE(nc);
-    s = natsConn_bufferWrite(nc, _PING_PROTO_, _PING_PROTO_LEN_);
+    // Messages staged by publishers need to be sent before the PING.
+    s = natsConn_drainPubStages(nc);
+    if (s == NATS_OK)
+        s = natsConn_bufferWrite(nc, _PING_PROTO_, _PING_PROTO_LEN_);
     if (s == NATS_OK)
     {
         // Flush the buffer in place.
@@ -2325,6 +2891,7 @@ _removeAllSubscriptions(natsConnection *nc)
     while (natsHashIter_Next(&iter, NULL, (void**) &sub))
     {
         (void) natsHashIter_RemoveCurrent(&iter);
+        natsSubTable_Remove(nc->subTable, sub->sid);
 
         natsSub_close(sub, true);
 
@@ -2348,6 +2915,11 @@ _close(natsConnection *nc, natsConnStatus status, bool fromPublicClose, bool doC
 
     natsConn_lockAndRetain(nc);
 
+    // Stop staging publish calls and move the messages staged so far
+    // to the outbound buffer so that they are flushed below.
+    _setPubStagesOpen(nc, false);
+    natsConn_drainPubStages(nc);
+
     // If invoked from the public Close() call, attempt to flush
     // to ensure that server has received all pending data.
     // Note that _flushTimeout will release the lock and wait
@@ -2372,6 +2944,9 @@ _close(natsConnection *nc, natsConnStatus status, bool fromPublicClose, bool doC
 
     _initThreadsToJoin(&ttj, nc, true);
 
+    // Kick out publish calls waiting for room in the outbound buffers.
+    natsCondition_Broadcast(nc->outboundCond);
+
     // Kick out all calls to natsConnection_Flush[Timeout]().
     _clearPendingFlushRequests(nc);
 
@@ -2395,12 +2970,16 @@ _close(natsConnection *nc, natsConnStatus status, bool fromPublicClose, bool doC
         // the socket. Otherwise, _readLoop is the one doing it.
         if ((ttj.readLoop == NULL) && (nc->opts->evLoop == NULL))
         {
+            natsMutex_Lock(nc->writeMu);
+
             natsSock_Close(nc->sockCtx.fd);
             nc->sockCtx.fd = NATS_SOCK_INVALID;
 
             // We need to cleanup some things if the connection was SSL.
             if (nc->sockCtx.ssl != NULL)
                 natsConn_clearSSL(nc);
+
+            natsMutex_Unlock(nc->writeMu);
         }
         else
         {
@@ -2459,6 +3038,7 @@ _createMsg(natsMsg **newMsg, natsConnection *nc, char *buf, int bufLen)
     int         subjLen  = 0;
     char        *reply   = NULL;
     int         replyLen = 0;
+    bool        hit      = false;
 
     subjLen = natsBuf_Len(nc->ps->ma.subject);
 
@@ -2468,114 +3048,169 @@ _createMsg(natsMsg **newMsg, natsConnection *nc, char *buf, int bufLen)
         replyLen = natsBuf_Len(nc->ps->ma.reply);
     }
 
-    s = natsMsg_create(newMsg,
-                       (const char*) natsBuf_Data(nc->ps->ma.subject), subjLen,
-                       (const char*) reply, replyLen,
-                       (const char*) buf, bufLen);
-    return s;
-}
-
-natsStatus
-natsConn_processMsg(natsConnection *nc, char *buf, int bufLen)
-{
-    natsStatus       s    = NATS_OK;
-    natsSubscription *sub = NULL;
-    natsMsg          *msg = NULL;
-    natsMsgDlvWorker *ldw = NULL;
-    bool             sc   = false;
-
-    natsMutex_Lock(nc->subsMu);
-
-    nc->stats.inMsgs  += 1;
-    nc->stats.inBytes += (uint64_t) bufLen;
-
-    sub = natsHash_Get(nc->subs, nc->ps->ma.sid);
-    if (sub == NULL)
+    // If the message was not split across reads, the arguments and
+    // payload are still in the slab being parsed, and each of them is
+    // followed by at least one byte that the parser no longer needs.
+    if ((nc->ps->slab != NULL)
+        && (nc->ps->argBuf == NULL)
+        && (nc->ps->msgBuf == NULL))
     {
-        natsMutex_Unlock(nc->subsMu);
-        return NATS_OK;
+        s = natsMsg_createFromSlab(newMsg, nc->msgPool, &hit, nc->ps->slab,
+                                   natsBuf_Data(nc->ps->ma.subject), subjLen,
+                                   reply, replyLen,
+                                   buf, bufLen);
+    }
+    else
+    {
+        s = natsMsg_createFromPool(newMsg, nc->msgPool, &hit,
+                                   (const char*) natsBuf_Data(nc->ps->ma.subject), subjLen,
+                                   (const char*) reply, replyLen,
+                                   (const char*) buf, bufLen);
     }
 
-    // Do this outside of sub's lock, even if we end-up having to destroy
-    // it because we have reached the maxPendingMsgs count. This reduces
-    // lock contention.
-    s = _createMsg(&msg, nc, buf, bufLen);
-    if (s != NATS_OK)
+    // Without a free callback, natsMsg_Destroy() frees the message
+    // instead of passing it to the garbage collector.
+    if ((s == NATS_OK) && nc->opts->inlineMsgFree)
+        (*newMsg)->gc.freeCb = NULL;
+
+    // Those are added to the connection's stats in natsConn_dispatchMsgs().
+    if ((s == NATS_OK) && (nc->msgPool != NULL))
     {
-        natsMutex_Unlock(nc->subsMu);
-        return s;
+        if (hit)
+            nc->ps->msgPoolHits++;
+        else
+            nc->ps->msgPoolMisses++;
     }
 
-    if ((ldw = sub->libDlvWorker) != NULL)
+    return s;
+}
+
+static void
+_lockSubOrWorker(natsSubscription *sub, natsMsgDlvWorker *ldw)
+{
+    if (ldw != NULL)
         natsMutex_Lock(ldw->lock);
     else
         natsSub_Lock(sub);
+}
+
+static void
+_unlockSubOrWorker(natsSubscription *sub, natsMsgDlvWorker *ldw)
+{
+    if (ldw != NULL)
+        natsMutex_Unlock(ldw->lock);
+    else
+        natsSub_Unlock(sub);
+}
 
-    sub->msgList.msgs++;
-    sub->msgList.bytes += bufLen;
+// Sets '*max' to 'v' if greater. The CAS fails if the max is concurrently
+// reset, in which case it is checked again.
+static void
+_raiseMax(natsAtomicInt *max, int v)
+{
+    int cur;
 
-    if (((sub->msgsLimit > 0) && (sub->msgList.msgs > sub->msgsLimit))
-        || ((sub->bytesLimit > 0) && (sub->msgList.bytes > sub->bytesLimit)))
+    while (v > (cur = nats_atomicGet(max)))
     {
-        natsMsg_Destroy(msg);
+        if (nats_atomicCAS(max, cur, v))
+            break;
+    }
+}
 
-        sub->dropped++;
+// Pushes the messages of the batch to the subscription queue, evaluating
+// the pending limits for each message, and signals the subscription only
+// if it is parked (or schedules it in the library delivery pool). Messages
+// of inline subscriptions are instead passed to the callback right away.
+// The subscription (or worker) lock is acquired only if messages are
+// dropped, or if the subscription was flagged as a slow consumer.
+static void
+_dispatchBatch(natsConnection *nc, natsMsgBatch *batch)
+{
+    natsSubscription *sub       = batch->sub;
+    natsMsgDlvWorker *ldw       = sub->libDlvWorker;
+    natsMsg          *msg       = NULL;
+    natsMsg          *next      = NULL;
+    natsMsg          *head      = NULL;
+    natsMsg          *tail      = NULL;
+    bool             locked     = false;
+    bool             sc         = false;
+    int              msgs;
+    int              bytes;
+    int              addMsgs    = 0;
+    int              addBytes   = 0;
+
+    // Inline subscriptions have no queue, and so no pending limits.
+    if (sub->inlineDlv)
+    {
+        natsSub_deliverInline(sub, batch->head);
+        return;
+    }
 
-        sc = sub->slowConsumer;
-        sub->slowConsumer = true;
+    // The consumers only decrease those counts, so the limits can't be
+    // exceeded by the time the messages are added to the queue.
+    msgs  = nats_atomicGet(&(sub->pendingMsgs));
+    bytes = nats_atomicGet(&(sub->pendingBytes));
 
-        // Undo stats from above.
-        sub->msgList.msgs--;
-        sub->msgList.bytes -= bufLen;
-    }
-    else
+    for (msg = batch->head; msg != NULL; msg = next)
     {
-        natsMsgList *list = NULL;
+        next = msg->next;
+        msg->next = NULL;
 
-        if (sub->msgList.msgs > sub->msgsMax)
-            sub->msgsMax = sub->msgList.msgs;
+        if (((sub->msgsLimit > 0) && (msgs + 1 > sub->msgsLimit))
+            || ((sub->bytesLimit > 0) && (bytes + msg->dataLen > sub->bytesLimit)))
+        {
+            natsMsg_Destroy(msg);
 
-        if (sub->msgList.bytes > sub->bytesMax)
-            sub->bytesMax = sub->msgList.bytes;
+            if (!locked)
+            {
+                _lockSubOrWorker(sub, ldw);
+                locked = true;
+            }
 
-        sub->slowConsumer = false;
+            sub->dropped++;
 
-        if (ldw != NULL)
-        {
-            msg->sub = sub;
-            list = &ldw->msgList;
-        }
-        else
-        {
-            list = &sub->msgList;
-        }
+            sc = (sc || sub->slowConsumer);
+            sub->slowConsumer = true;
 
-        if (list->head == NULL)
-            list->head = msg;
+            continue;
+        }
 
-        if (list->tail != NULL)
-            list->tail->next = msg;
+        msgs++;
+        bytes += msg->dataLen;
 
-        list->tail = msg;
+        addMsgs++;
+        addBytes += msg->dataLen;
 
-        if (ldw != NULL)
+        // Only this thread sets it to true, so if it is seen as false,
+        // there is no need to lock.
+        if (sub->slowConsumer)
         {
-            if (ldw->inWait)
-                natsCondition_Broadcast(ldw->cond);
+            if (!locked)
+            {
+                _lockSubOrWorker(sub, ldw);
+                locked = true;
+            }
+            sub->slowConsumer = false;
         }
+
+        if (head == NULL)
+            head = msg;
         else
-        {
-            if (sub->inWait > 0)
-                natsCondition_Broadcast(sub->cond);
-        }
+            tail->next = msg;
+
+        tail = msg;
     }
 
-    if (ldw != NULL)
-        natsMutex_Unlock(ldw->lock);
-    else
-        natsSub_Unlock(sub);
+    if (locked)
+        _unlockSubOrWorker(sub, ldw);
 
-    natsMutex_Unlock(nc->subsMu);
+    // The pending counts only grow in the loop, so the max is reached at
+    // the end of it.
+    if (addMsgs > 0)
+    {
+        _raiseMax(&(sub->msgsMax), msgs);
+        _raiseMax(&(sub->bytesMax), bytes);
+    }
 
     if (sc)
     {
@@ -2589,6 +3224,139 @@ natsConn_processMsg(natsConnection *nc, char *buf, int bufLen)
         natsConn_Unlock(nc);
     }
 
+    if (head == NULL)
+        return;
+
+    // Update the pending counts first so that the consumer never
+    // sees them drop below 0.
+    nats_atomicAdd(&(sub->pendingMsgs), addMsgs);
+    nats_atomicAdd(&(sub->pendingBytes), addBytes);
+
+    if (ldw != NULL)
+    {
+        (void) natsMsgQueue_Push(&(sub->msgQ), head);
+
+        // Adds the subscription to a worker's run queue, unless it is
+        // already there or being delivered.
+        natsLib_msgDeliverySchedule(sub);
+
+        return;
+    }
+
+    // Lanes of parallel subscriptions have their own queue, unless they
+    // share the subscription's one when messages are unordered.
+    if ((sub->lanes != NULL) && (sub->laneOrder != NATS_PARALLEL_UNORDERED))
+    {
+        natsSub_dispatchToLanes(sub, head);
+        return;
+    }
+
+    if (natsMsgQueue_Push(&(sub->msgQ), head)
+        && (nats_atomicGet(&(sub->inWait)) > 0))
+    {
+        natsSub_Lock(sub);
+        natsCondition_Broadcast(sub->cond);
+        natsSub_Unlock(sub);
+    }
+}
+
+// Dispatches the messages batched by natsConn_processMsg(). This must be
+// called without holding any lock.
+void
+natsConn_dispatchMsgs(natsConnection *nc)
+{
+    natsParser      *ps = nc->ps;
+    natsMsgBatch    *batch;
+    int             i;
+
+    if ((ps->inMsgs > 0) || (ps->msgPoolHits > 0) || (ps->msgPoolMisses > 0))
+    {
+        natsMutex_Lock(nc->subsMu);
+
+        nc->stats.inMsgs        += ps->inMsgs;
+        nc->stats.inBytes       += ps->inBytes;
+        nc->stats.msgPoolHits   += ps->msgPoolHits;
+        nc->stats.msgPoolMisses += ps->msgPoolMisses;
+
+        natsMutex_Unlock(nc->subsMu);
+
+        ps->inMsgs        = 0;
+        ps->inBytes       = 0;
+        ps->msgPoolHits   = 0;
+        ps->msgPoolMisses = 0;
+    }
+
+    for (i=0; i<ps->numBatches; i++)
+    {
+        batch = &(ps->batches[i]);
+
+        _dispatchBatch(nc, batch);
+
+        // Release the reference added in natsConn_processMsg().
+        natsSub_release(batch->sub);
+
+        batch->sub  = NULL;
+        batch->head = NULL;
+        batch->tail = NULL;
+    }
+    ps->numBatches = 0;
+}
+
+natsStatus
+natsConn_processMsg(natsConnection *nc, char *buf, int bufLen)
+{
+    natsStatus       s     = NATS_OK;
+    natsSubscription *sub  = NULL;
+    natsMsg          *msg  = NULL;
+    natsParser       *ps   = nc->ps;
+    natsMsgBatch     *batch = NULL;
+    int              i;
+
+    // Make room for a new batch if needed.
+    if (ps->numBatches == NATS_PARSER_MAX_BATCHES)
+        natsConn_dispatchMsgs(nc);
+
+    ps->inMsgs  += 1;
+    ps->inBytes += (uint64_t) bufLen;
+
+    // No lock needed, natsParser_Parse() has entered the table.
+    sub = natsSubTable_Get(nc->subTable, ps->ma.sid);
+    if (sub == NULL)
+        return NATS_OK;
+
+    // Do this outside of sub's lock, even if we end-up having to destroy
+    // it because we have reached the maxPendingMsgs count. This reduces
+    // lock contention.
+    s = _createMsg(&msg, nc, buf, bufLen);
+    if (s != NATS_OK)
+        return s;
+
+    // The message is added to the subscription's batch. Pending limits
+    // are evaluated when the batch is dispatched.
+    for (i=0; (batch == NULL) && (i<ps->numBatches); i++)
+    {
+        if (ps->batches[i].sub == sub)
+            batch = &(ps->batches[i]);
+    }
+    if (batch == NULL)
+    {
+        batch = &(ps->batches[ps->numBatches++]);
+
+        // The subscription may be removed before the batch is dispatched.
+        natsSub_retain(sub);
+
+        batch->sub  = sub;
+        batch->head = NULL;
+        batch->tail = NULL;
+    }
+
+    if (batch->head == NULL)
+        batch->head = msg;
+    else
+        batch->tail->next = msg;
+
+    batch->tail = msg;
+
     return s;
 }
 
@@ -2700,6 +3468,10 @@ natsConn_processPong(natsConnection *nc)
 {
     natsPong *pong = NULL;
 
+    // Messages received before this PONG must be in their subscription
+    // before a Flush[Timeout] call is released.
+    natsConn_dispatchMsgs(nc);
+
     natsConn_Lock(nc);
 
     nc->pongs.incoming++;
@@ -2736,6 +3508,13 @@ natsConn_addSubcription(natsConnection *nc, natsSubscription *sub)
     {
         assert(oldSub == NULL);
         natsSub_retain(sub);
+
+        s = natsSubTable_Set(nc->subTable, sub);
+        if (s != NATS_OK)
+        {
+            (void) natsHash_Remove(nc->subs, sub->sid);
+            natsSub_release(sub);
+        }
     }
 
     return NATS_UPDATE_ERR_STACK(s);
@@ -2749,6 +3528,7 @@ natsConn_removeSubscription(natsConnection *nc, natsSubscription *removedSub)
     natsMutex_Lock(nc->subsMu);
 
     sub = natsHash_Remove(nc->subs, removedSub->sid);
+    natsSubTable_Remove(nc->subTable, removedSub->sid);
 
     // Note that the sub may have already been removed, so 'sub == NULL'
     // is not an error.
@@ -2806,7 +3586,10 @@ natsStatus
 natsConn_subscribeImpl(natsSubscription **newSub,
                        natsConnection *nc, const char *subj, const char *queue,
                        int64_t timeout, natsMsgHandler cb, void *cbClosure,
-                       bool preventUseOfLibDlvPool)
+                       natsMsgBatchHandler batchCb, int maxBatch, int64_t linger,
+                       int lanes, natsParallelOrder order, natsMsgKeyHandler keyCb,
+                       bool inlineDlv, bool preventUseOfLibDlvPool,
+                       natsOnCompleteCB onCompleteCB, void *onCompleteCBClosure)
 {
     natsStatus          s    = NATS_OK;
     natsSubscription    *sub = NULL;
@@ -2836,7 +3619,17 @@ natsConn_subscribeImpl(natsSubscription **newSub,
         return nats_setDefaultError(NATS_DRAINING);
     }
 
-    s = natsSub_create(&sub, nc, subj, queue, timeout, cb, cbClosure, preventUseOfLibDlvPool);
+    s = natsSub_create(&sub, nc, subj, queue, timeout, cb, cbClosure,
+                       batchCb, maxBatch, linger, lanes, order, keyCb,
+                       inlineDlv, preventUseOfLibDlvPool);
+    if ((s == NATS_OK) && (onCompleteCB != NULL))
+    {
+        // Set before the subscription is added to the connection, so that
+        // the callback is invoked even if the subscription is closed right
+        // after being created.
+        sub->onCompleteCB        = onCompleteCB;
+        sub->onCompleteCBClosure = onCompleteCBClosure;
+    }
     if (s == NATS_OK)
     {
         natsMutex_Lock(nc->subsMu);
@@ -2889,7 +3682,13 @@ natsConn_subscribeImpl(natsSubscription **newSub,
     {
         // A delivery thread may have been started, but the subscription not
         // added to the connection's subscription map. So this is necessary
-        // for the delivery thread to unroll.
+        // for the delivery thread to unroll. The completion callback is
+        // not invoked for a subscription that is not returned.
+        natsSub_Lock(sub);
+        sub->onCompleteCB        = NULL;
+        sub->onCompleteCBClosure = NULL;
+        natsSub_Unlock(sub);
+
         natsSub_close(sub, false);
 
         natsConn_removeSubscription(nc, sub);
@@ -2961,6 +3760,10 @@ natsConn_drainSub(natsConnection *nc, natsSubscription *sub, bool checkConnDrain
 {
     natsStatus s = NATS_OK;
 
+    // Check before sending the UNSUB, since the flush below would fail.
+    if (nats_isInlineDeliveryConn(nc))
+        return nats_setError(NATS_ILLEGAL_STATE, "%s", INLINE_DLV_BLOCKING_ERR);
+
     natsConn_Lock(nc);
     if (natsConn_isClosed(nc))
         s = nats_setDefaultError(NATS_CONNECTION_CLOSED);
@@ -3045,12 +3848,16 @@ natsConn_create(natsConnection **newConn, natsOptions *options)
     nc->errStr[0] = '\0';
 
     s = natsMutex_Create(&(nc->mu));
+    if (s == NATS_OK)
+        s = natsMutex_Create(&(nc->writeMu));
     if (s == NATS_OK)
         s = natsMutex_Create(&(nc->subsMu));
     if (s == NATS_OK)
         s = _setupServerPool(nc);
     if (s == NATS_OK)
         s = natsHash_Create(&(nc->subs), 8);
+    if (s == NATS_OK)
+        s = natsSubTable_Create(&(nc->subTable));
     if (s == NATS_OK)
         s = natsSock_Init(&nc->sockCtx);
     if (s == NATS_OK)
@@ -3065,6 +3872,20 @@ natsConn_create(natsConnection **newConn, natsOptions *options)
         s = natsCondition_Create(&(nc->pongs.cond));
     if (s == NATS_OK)
         s = natsCondition_Create(&(nc->reconnectCond));
+    if (s == NATS_OK)
+        s = natsCondition_Create(&(nc->outboundCond));
+    if ((s == NATS_OK) && nc->opts->concurrentPublish && !(nc->opts->sendAsap)
+        && (nc->opts->maxOutboundBytes <= 0))
+    {
+        s = _createPubStages(nc);
+    }
+    if ((s == NATS_OK) && nc->opts->msgPool)
+    {
+        if (nc->opts->msgPoolMaxFree == 0)
+            nc->opts->msgPoolMaxFree = NATS_OPTS_DEFAULT_MSG_POOL_MAX_FREE;
+
+        s = natsMsgPool_Create(&(nc->msgPool), nc->opts->msgPoolMaxFree);
+    }
 
     if (s == NATS_OK)
         *newConn = nc;
@@ -3296,7 +4117,7 @@ _flushTimeout(natsConnection *nc, int64_t timeout)
         // Send the ping (and add the pong to the list)
         _sendPing(nc, pong);
 
-        target = nats_Now() + timeout;
+        target = nats_monotonicNow() + timeout;
 
         // When the corresponding PONG is received, the PONG processing code
         // will set pong->id to 0 and do a broadcast. This will allow this
@@ -3351,6 +4172,10 @@ natsConnection_FlushTimeout(natsConnection *nc, int64_t timeout)
     if (timeout <= 0)
         return nats_setDefaultError(NATS_INVALID_TIMEOUT);
 
+    // The PONG would be read by the thread waiting for it.
+    if (nats_isInlineDeliveryConn(nc))
+        return nats_setError(NATS_ILLEGAL_STATE, "%s", INLINE_DLV_BLOCKING_ERR);
+
     natsConn_lockAndRetain(nc);
 
     if (natsConn_isClosed(nc))
@@ -3402,6 +4227,9 @@ _drainPubsAndClose(natsConnection *nc)
     // Flip state
     natsConn_Lock(nc);
     nc->status = NATS_CONN_STATUS_DRAINING_PUBS;
+    // New publish calls are rejected, but messages already staged
+    // will be sent by the Flush() call below.
+    _setPubStagesOpen(nc, false);
     natsConn_Unlock(nc);
 
     // Do publish drain via Flush() call.
@@ -3429,7 +4257,7 @@ _checkAllSubsAreDrained(natsTimer *t, void *closure)
     doneWithSubs = _areAllSubsDrained(nc);
     if (!doneWithSubs
             && (nc->drainDeadline > 0)
-            && (nats_Now() > nc->drainDeadline))
+            && (nats_monotonicNow() > nc->drainDeadline))
     {
         timedOut     = true;
         doneWithSubs = true;
@@ -3479,6 +4307,8 @@ _drain(natsConnection *nc, int64_t timeout)
         s = nats_setError(NATS_ILLEGAL_STATE, "%s", "Illegal to call Drain for connection owned by a streaming connection");
     else if (_isConnecting(nc) || natsConn_isReconnecting(nc))
         s = nats_setError(NATS_ILLEGAL_STATE, "%s", "Illegal to call Drain while the connection is reconnecting");
+    else if (nats_isInlineDeliveryConn(nc))
+        s = nats_setError(NATS_ILLEGAL_STATE, "%s", INLINE_DLV_BLOCKING_ERR);
     else if (natsConn_isDraining(nc))
         draining = true;
     if ((s == NATS_OK) && !draining)
@@ -3511,7 +4341,7 @@ _drain(natsConnection *nc, int64_t timeout)
 
     nc->status = NATS_CONN_STATUS_DRAINING_SUBS;
     if (timeout > 0)
-        nc->drainDeadline = nats_Now() + timeout;
+        nc->drainDeadline = nats_monotonicNow() + timeout;
     _retain(nc);
 
     natsConn_Unlock(nc);
@@ -3588,7 +4418,15 @@ natsConnection_Buffered(natsConnection *nc)
     natsConn_Lock(nc);
 
     if ((nc->status != NATS_CONN_STATUS_CLOSED) && (nc->bw != NULL))
+    {
         buffered = natsBuf_Len(nc->bw);
+        // Add what the flusher may be currently sending.
+        if (nc->bwBack != NULL)
+            buffered += natsBuf_Len(nc->bwBack);
+        // And what is waiting to be sent after a reconnect.
+        if (nc->pending != NULL)
+            buffered += (int) natsSegBuf_Len(nc->pending);
+    }
 
     natsConn_Unlock(nc);
 
@@ -3875,6 +4713,9 @@ natsConnection_ProcessWriteEvent(natsConnection *nc)
     s = natsSock_Write(&(nc->sockCtx), buf, len, &n);
     if (s == NATS_OK)
     {
+        nc->stats.flushes++;
+        nc->stats.flushedBytes += (uint64_t) n;
+
         if (n == len)
         {
             // We sent all the data, reset buffer and remove WRITE event.
@@ -3892,6 +4733,7 @@ natsConnection_ProcessWriteEvent(natsConnection *nc)
             // We sent some part of the buffer. Move the remaining at the beginning.
             natsBuf_Consume(nc->bw, n);
         }
+        natsConn_outboundChanged(nc);
     }
 
     natsConn_Unlock(nc);
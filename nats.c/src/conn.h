@@ -58,6 +58,15 @@ natsConn_isReconnecting(natsConnection *nc);
 natsStatus
 natsConn_flushOrKickFlusher(natsConnection *nc);
 
+natsStatus
+natsConn_drainPubStages(natsConnection *nc);
+
+natsStatus
+natsConn_reserveOutbound(natsConnection *nc, int size, bool *drop);
+
+void
+natsConn_outboundChanged(natsConnection *nc);
+
 natsStatus
 natsConn_processMsg(natsConnection *nc, char *buf, int bufLen);
 
@@ -73,20 +82,27 @@ natsConn_processPing(natsConnection *nc);
 void
 natsConn_processPong(natsConnection *nc);
 
-#define natsConn_subscribeNoPool(sub, nc, subj, cb, closure)                            natsConn_subscribeImpl((sub), (nc), (subj), NULL, 0, (cb), (closure), true)
+#define natsConn_subscribeNoPool(sub, nc, subj, cb, closure)                            natsConn_subscribeImpl((sub), (nc), (subj), NULL, 0, (cb), (closure), NULL, 0, 0, 0, NATS_PARALLEL_UNORDERED, NULL, false, true, NULL, NULL)
 #define natsConn_subscribeSyncNoPool(sub, nc, subj)                                     natsConn_subscribeNoPool((sub), (nc), (subj), NULL, NULL)
-#define natsConn_subscribeWithTimeout(sub, nc, subj, timeout, cb, closure)              natsConn_subscribeImpl((sub), (nc), (subj), NULL, (timeout), (cb), (closure), false)
+#define natsConn_subscribeWithTimeout(sub, nc, subj, timeout, cb, closure)              natsConn_subscribeImpl((sub), (nc), (subj), NULL, (timeout), (cb), (closure), NULL, 0, 0, 0, NATS_PARALLEL_UNORDERED, NULL, false, false, NULL, NULL)
 #define natsConn_subscribe(sub, nc, subj, cb, closure)                                  natsConn_subscribeWithTimeout((sub), (nc), (subj), 0, (cb), (closure))
 #define natsConn_subscribeSync(sub, nc, subj)                                           natsConn_subscribe((sub), (nc), (subj), NULL, NULL)
-#define natsConn_queueSubscribeWithTimeout(sub, nc, subj, queue, timeout, cb, closure)  natsConn_subscribeImpl((sub), (nc), (subj), (queue), (timeout), (cb), (closure), false)
+#define natsConn_queueSubscribeWithTimeout(sub, nc, subj, queue, timeout, cb, closure)  natsConn_subscribeImpl((sub), (nc), (subj), (queue), (timeout), (cb), (closure), NULL, 0, 0, 0, NATS_PARALLEL_UNORDERED, NULL, false, false, NULL, NULL)
 #define natsConn_queueSubscribe(sub, nc, subj, queue, cb, closure)                      natsConn_queueSubscribeWithTimeout((sub), (nc), (subj), (queue), 0, (cb), (closure))
 #define natsConn_queueSubscribeSync(sub, nc, subj, queue)                               natsConn_queueSubscribe((sub), (nc), (subj), (queue), NULL, NULL)
+#define natsConn_subscribeBatch(sub, nc, subj, timeout, maxBatch, linger, cb, closure)  natsConn_subscribeImpl((sub), (nc), (subj), NULL, (timeout), NULL, (closure), (cb), (maxBatch), (linger), 0, NATS_PARALLEL_UNORDERED, NULL, false, true, NULL, NULL)
+#define natsConn_subscribeParallel(sub, nc, subj, lanes, order, keyCb, cb, closure)    natsConn_subscribeImpl((sub), (nc), (subj), NULL, 0, (cb), (closure), NULL, 0, 0, (lanes), (order), (keyCb), false, true, NULL, NULL)
+#define natsConn_subscribeInline(sub, nc, subj, cb, closure)                            natsConn_subscribeImpl((sub), (nc), (subj), NULL, 0, (cb), (closure), NULL, 0, 0, 0, NATS_PARALLEL_UNORDERED, NULL, true, true, NULL, NULL)
+#define natsConn_subscribeWithCompleteCB(sub, nc, subj, cb, closure, compCb, compClosure) natsConn_subscribeImpl((sub), (nc), (subj), NULL, 0, (cb), (closure), NULL, 0, 0, 0, NATS_PARALLEL_UNORDERED, NULL, false, false, (compCb), (compClosure))
 
 natsStatus
 natsConn_subscribeImpl(natsSubscription **newSub,
                        natsConnection *nc, const char *subj, const char *queue,
                        int64_t timeout, natsMsgHandler cb, void *cbClosure,
-                       bool preventUseOfLibDlvPool);
+                       natsMsgBatchHandler batchCb, int maxBatch, int64_t linger,
+                       int lanes, natsParallelOrder order, natsMsgKeyHandler keyCb,
+                       bool inlineDlv, bool preventUseOfLibDlvPool,
+                       natsOnCompleteCB onCompleteCB, void *onCompleteCBClosure);
 
 natsStatus
 natsConn_unsubscribe(natsConnection *nc, natsSubscription *sub, int max);
@@ -100,6 +116,12 @@ natsConn_isDraining(natsConnection *nc);
 bool
 natsConn_isDrainingPubs(natsConnection *nc);
 
+natsStatus
+natsConn_addSubcription(natsConnection *nc, natsSubscription *sub);
+
+void
+natsConn_dispatchMsgs(natsConnection *nc);
+
 void
 natsConn_removeSubscription(natsConnection *nc, natsSubscription *sub);
 
@@ -41,6 +41,7 @@ typedef pthread_cond_t  natsCondition;
 typedef pthread_once_t  natsInitOnceType;
 typedef socklen_t       natsSockLen;
 typedef size_t          natsRecvLen;
+typedef int32_t         natsAtomicInt;
 
 #define NATS_ONCE_STATIC_INIT   PTHREAD_ONCE_INIT
 
@@ -51,6 +52,32 @@ typedef size_t          natsRecvLen;
 #define NATS_SOCK_WOULD_BLOCK           (EWOULDBLOCK)
 #define NATS_SOCK_ERROR                 (-1)
 #define NATS_SOCK_GET_ERROR             (errno)
+#define NATS_SOCK_IOV_MAX               (64)
+
+// Atomically increment/decrement (or add 'v' to) a natsAtomicInt and return
+// the new value, or return its current value.
+#define nats_atomicInc(p)               (__sync_add_and_fetch((p), 1))
+#define nats_atomicDec(p)               (__sync_sub_and_fetch((p), 1))
+#define nats_atomicGet(p)               (__sync_add_and_fetch((p), 0))
+#define nats_atomicAdd(p, v)            (__sync_add_and_fetch((p), (v)))
+
+// Atomically replace the natsAtomicInt '*p' with 'n' if it is equal to 'o'
+// (returns true if so).
+#define nats_atomicCAS(p, o, n)         (__sync_bool_compare_and_swap((p), (o), (n)))
+
+// Atomically replace the pointer '*p' with 'n' if it is equal to 'o'
+// (returns true if so), or unconditionally with 'v' (returns the old value).
+#define nats_atomicCASPtr(p, o, n)      (__sync_bool_compare_and_swap((p), (o), (n)))
+#define nats_atomicSwapPtr(p, v)        (__sync_lock_test_and_set((p), (v)))
+
+// Hint to the CPU that we are in a spin-wait loop.
+#if defined(__i386__) || defined(__x86_64__)
+#define nats_cpuPause()                 __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define nats_cpuPause()                 __asm__ __volatile__("yield")
+#else
+#define nats_cpuPause()
+#endif
 
 #define __NATS_FUNCTION__ __func__
 
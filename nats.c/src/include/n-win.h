@@ -40,6 +40,7 @@ typedef CONDITION_VARIABLE  natsCondition;
 typedef INIT_ONCE           natsInitOnceType;
 typedef int                 natsSockLen;
 typedef int                 natsRecvLen;
+typedef LONG                natsAtomicInt;
 
 #define NATS_ONCE_TYPE          INIT_ONCE
 #define NATS_ONCE_STATIC_INIT   INIT_ONCE_STATIC_INIT
@@ -51,6 +52,26 @@ typedef int                 natsRecvLen;
 #define NATS_SOCK_WOULD_BLOCK           (WSAEWOULDBLOCK)
 #define NATS_SOCK_ERROR                 (SOCKET_ERROR)
 #define NATS_SOCK_GET_ERROR             WSAGetLastError()
+#define NATS_SOCK_IOV_MAX               (64)
+
+// Atomically increment/decrement (or add 'v' to) a natsAtomicInt and return
+// the new value, or return its current value.
+#define nats_atomicInc(p)               (InterlockedIncrement((p)))
+#define nats_atomicDec(p)               (InterlockedDecrement((p)))
+#define nats_atomicGet(p)               (InterlockedCompareExchange((p), 0, 0))
+#define nats_atomicAdd(p, v)            (InterlockedExchangeAdd((p), (v)) + (v))
+
+// Atomically replace the natsAtomicInt '*p' with 'n' if it is equal to 'o'
+// (returns true if so).
+#define nats_atomicCAS(p, o, n)         (InterlockedCompareExchange((p), (n), (o)) == (o))
+
+// Atomically replace the pointer '*p' with 'n' if it is equal to 'o'
+// (returns true if so), or unconditionally with 'v' (returns the old value).
+#define nats_atomicCASPtr(p, o, n)      (InterlockedCompareExchangePointer((PVOID volatile*)(p), (PVOID)(n), (PVOID)(o)) == (PVOID)(o))
+#define nats_atomicSwapPtr(p, v)        (InterlockedExchangePointer((PVOID volatile*)(p), (PVOID)(v)))
+
+// Hint to the CPU that we are in a spin-wait loop.
+#define nats_cpuPause()                 YieldProcessor()
 
 #define __NATS_FUNCTION__ __FUNCTION__
 
@@ -19,6 +19,151 @@
 
 #include "mem.h"
 
+static const int _poolClassSizes[NATS_MSG_POOL_CLASSES] = {128, 512, 2048, 8192};
+
+static void
+_freeMsgList(natsMsg *msg)
+{
+    natsMsg *next;
+
+    while (msg != NULL)
+    {
+        next = msg->next;
+        NATS_FREE(msg);
+        msg = next;
+    }
+}
+
+static void
+_poolFree(natsMsgPool *pool)
+{
+    natsMsgPoolStripe   *stripe;
+    int                 i, j;
+
+    for (i=0; i<NATS_MSG_POOL_CLASSES; i++)
+        _freeMsgList(pool->cache[i]);
+
+    for (i=0; i<NATS_MSG_POOL_STRIPES; i++)
+    {
+        stripe = &(pool->stripes[i]);
+
+        for (j=0; j<NATS_MSG_POOL_CLASSES; j++)
+            _freeMsgList(stripe->free[j]);
+
+        natsMutex_Destroy(stripe->mu);
+    }
+
+    NATS_FREE(pool);
+}
+
+static void
+_poolRelease(natsMsgPool *pool)
+{
+    if (nats_atomicDec(&(pool->refs)) == 0)
+        _poolFree(pool);
+}
+
+static void
+_poolPut(natsMsg *msg)
+{
+    natsMsgPool         *pool   = msg->pool;
+    natsMsgPoolStripe   *stripe = NULL;
+    int                 c       = msg->poolClass;
+    bool                kept    = false;
+
+    stripe = &(pool->stripes[nats_getThreadIndex() % NATS_MSG_POOL_STRIPES]);
+
+    natsMutex_Lock(stripe->mu);
+    if (stripe->count[c] < pool->maxFreePerStripe)
+    {
+        msg->next = stripe->free[c];
+        stripe->free[c] = msg;
+        stripe->count[c]++;
+        kept = true;
+    }
+    natsMutex_Unlock(stripe->mu);
+
+    if (!kept)
+        NATS_FREE(msg);
+
+    _poolRelease(pool);
+}
+
+// Moves all free messages of the class 'c' from the first non empty
+// stripe to the private list of the pool.
+static void
+_poolRefill(natsMsgPool *pool, int c)
+{
+    natsMsgPoolStripe   *stripe;
+    int                 i;
+
+    for (i=0; (pool->cache[c] == NULL) && (i<NATS_MSG_POOL_STRIPES); i++)
+    {
+        stripe = &(pool->stripes[i]);
+
+        natsMutex_Lock(stripe->mu);
+        pool->cache[c]   = stripe->free[c];
+        stripe->free[c]  = NULL;
+        stripe->count[c] = 0;
+        natsMutex_Unlock(stripe->mu);
+    }
+}
+
+// Allocates the memory for a message of 'size' bytes (including the
+// natsMsg structure), from the pool if one is provided and the size
+// is not too big.
+static natsStatus
+_allocMsg(natsMsg **newMsg, natsMsgPool *pool, bool *hit, int size)
+{
+    natsMsg *msg = NULL;
+    int     c    = -1;
+    int     i;
+
+    if (pool != NULL)
+    {
+        for (i=0; (c < 0) && (i<NATS_MSG_POOL_CLASSES); i++)
+        {
+            if (size <= _poolClassSizes[i])
+                c = i;
+        }
+    }
+    if (c < 0)
+    {
+        msg = NATS_MALLOC(size);
+        if (msg == NULL)
+            return nats_setDefaultError(NATS_NO_MEMORY);
+
+        msg->pool = NULL;
+    }
+    else
+    {
+        if (pool->cache[c] == NULL)
+            _poolRefill(pool, c);
+
+        if ((msg = pool->cache[c]) != NULL)
+        {
+            pool->cache[c] = msg->next;
+            if (hit != NULL)
+                *hit = true;
+        }
+        else
+        {
+            msg = NATS_MALLOC(_poolClassSizes[c]);
+            if (msg == NULL)
+                return nats_setDefaultError(NATS_NO_MEMORY);
+        }
+
+        nats_atomicInc(&(pool->refs));
+
+        msg->pool      = pool;
+        msg->poolClass = c;
+    }
+
+    *newMsg = msg;
+
+    return NATS_OK;
+}
+
 void
 natsMsg_free(void *object)
 {
@@ -29,7 +174,13 @@ natsMsg_free(void *object)
 
     msg = (natsMsg*) object;
 
-    NATS_FREE(msg);
+    if (msg->slab != NULL)
+        natsMsgSlab_Release(msg->slab);
+
+    if (msg->pool != NULL)
+        _poolPut(msg);
+    else
+        NATS_FREE(msg);
 }
 
 void
@@ -81,11 +232,12 @@ natsMsg_GetDataLength(natsMsg *msg)
 }
 
 natsStatus
-natsMsg_create(natsMsg **newMsg,
-               const char *subject, int subjLen,
-               const char *reply, int replyLen,
-               const char *buf, int bufLen)
+natsMsg_createFromPool(natsMsg **newMsg, natsMsgPool *pool, bool *hit,
+                       const char *subject, int subjLen,
+                       const char *reply, int replyLen,
+                       const char *buf, int bufLen)
 {
+    natsStatus  s         = NATS_OK;
     natsMsg     *msg      = NULL;
     char        *ptr      = NULL;
     int         bufSize   = 0;
@@ -100,9 +252,9 @@ natsMsg_create(natsMsg **newMsg,
     bufSize += bufLen;
     bufSize += 1;
 
-    msg = NATS_MALLOC(sizeof(natsMsg) + bufSize);
-    if (msg == NULL)
-        return nats_setDefaultError(NATS_NO_MEMORY);
+    s = _allocMsg(&msg, pool, hit, (int) sizeof(natsMsg) + bufSize);
+    if (s != NATS_OK)
+        return NATS_UPDATE_ERR_STACK(s);
 
     // To be safe, we could 'memset' the message up to sizeof(natsMsg),
     // but since we are explicitly initializing most of the fields, we save
@@ -114,6 +266,7 @@ natsMsg_create(natsMsg **newMsg,
     memset(&(msg->gc), 0, sizeof(natsGCItem));
 
     msg->sub  = NULL;
+    msg->slab = NULL;
     msg->next = NULL;
 
     ptr = (char*) (((char*) &(msg->next)) + sizeof(msg->next));
@@ -153,6 +306,139 @@ natsMsg_create(natsMsg **newMsg,
     return NATS_OK;
 }
 
+natsStatus
+natsMsg_create(natsMsg **newMsg,
+               const char *subject, int subjLen,
+               const char *reply, int replyLen,
+               const char *buf, int bufLen)
+{
+    natsStatus s;
+
+    s = natsMsg_createFromPool(newMsg, NULL, NULL,
+                               subject, subjLen,
+                               reply, replyLen,
+                               buf, bufLen);
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
+natsStatus
+natsMsg_createFromSlab(natsMsg **newMsg, natsMsgPool *pool, bool *hit,
+                       natsMsgSlab *slab,
+                       char *subject, int subjLen,
+                       char *reply, int replyLen,
+                       char *buf, int bufLen)
+{
+    natsStatus  s;
+    natsMsg     *msg = NULL;
+
+    s = _allocMsg(&msg, pool, hit, (int) sizeof(natsMsg));
+    if (s != NATS_OK)
+        return NATS_UPDATE_ERR_STACK(s);
+
+    memset(&(msg->gc), 0, sizeof(natsGCItem));
+
+    msg->sub  = NULL;
+    msg->next = NULL;
+
+    subject[subjLen] = '\0';
+    msg->subject = (const char*) subject;
+
+    if (replyLen > 0)
+    {
+        reply[replyLen] = '\0';
+        msg->reply = (const char*) reply;
+    }
+    else
+    {
+        msg->reply = NULL;
+    }
+
+    buf[bufLen]  = '\0';
+    msg->data    = (const char*) buf;
+    msg->dataLen = bufLen;
+
+    natsMsgSlab_Retain(slab);
+    msg->slab = slab;
+
+    msg->gc.freeCb = natsMsg_free;
+
+    *newMsg = msg;
+
+    return NATS_OK;
+}
+
+natsStatus
+natsMsgSlab_Create(natsMsgSlab **newSlab, int size)
+{
+    natsMsgSlab *slab = NULL;
+
+    // The structure and the data are allocated in one block.
+    slab = (natsMsgSlab*) NATS_MALLOC(sizeof(natsMsgSlab) + size);
+    if (slab == NULL)
+        return nats_setDefaultError(NATS_NO_MEMORY);
+
+    slab->refs = 1;
+    slab->size = size;
+    slab->data = (char*) (slab + 1);
+
+    *newSlab = slab;
+
+    return NATS_OK;
+}
+
+void
+natsMsgSlab_Retain(natsMsgSlab *slab)
+{
+    nats_atomicInc(&(slab->refs));
+}
+
+void
+natsMsgSlab_Release(natsMsgSlab *slab)
+{
+    if (slab == NULL)
+        return;
+
+    if (nats_atomicDec(&(slab->refs)) == 0)
+        NATS_FREE(slab);
+}
+
+natsStatus
+natsMsgPool_Create(natsMsgPool **newPool, int maxFree)
+{
+    natsStatus  s     = NATS_OK;
+    natsMsgPool *pool = NULL;
+    int         i;
+
+    pool = (natsMsgPool*) NATS_CALLOC(1, sizeof(natsMsgPool));
+    if (pool == NULL)
+        return nats_setDefaultError(NATS_NO_MEMORY);
+
+    pool->refs             = 1;
+    pool->maxFreePerStripe = maxFree / NATS_MSG_POOL_STRIPES;
+    if (pool->maxFreePerStripe == 0)
+        pool->maxFreePerStripe = 1;
+
+    for (i=0; (s == NATS_OK) && (i<NATS_MSG_POOL_STRIPES); i++)
+        s = natsMutex_Create(&(pool->stripes[i].mu));
+
+    if (s == NATS_OK)
+        *newPool = pool;
+    else
+        _poolFree(pool);
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
+void
+natsMsgPool_Release(natsMsgPool *pool)
+{
+    if (pool == NULL)
+        return;
+
+    _poolRelease(pool);
+}
+
 natsStatus
 natsMsg_Create(natsMsg **newMsg, const char *subj, const char *reply,
                const char *data, int dataLen)
@@ -174,3 +460,105 @@ natsMsg_Create(natsMsg **newMsg, const char *subj, const char *reply,
     return NATS_UPDATE_ERR_STACK(s);
 }
 
+bool
+natsMsgQueue_Push(natsMsgQueue *q, natsMsg *head)
+{
+    natsMsg *first = NULL;
+    natsMsg *last  = head;
+    natsMsg *next;
+    natsMsg *in;
+
+    // Reverse the list since 'in' has the most recent message first.
+    while (head != NULL)
+    {
+        next       = head->next;
+        head->next = first;
+        first      = head;
+        head       = next;
+    }
+
+    do
+    {
+        in = q->in;
+        last->next = in;
+    }
+    while (!nats_atomicCASPtr(&(q->in), in, first));
+
+    return (in == NULL);
+}
+
+natsMsg*
+natsMsgQueue_Pop(natsMsgQueue *q)
+{
+    natsMsg *msg;
+    natsMsg *list;
+    natsMsg *next;
+
+    if ((msg = q->out) == NULL)
+    {
+        if (q->in == NULL)
+            return NULL;
+
+        list = (natsMsg*) nats_atomicSwapPtr(&(q->in), NULL);
+
+        // Put the messages back in the order they were pushed.
+        while (list != NULL)
+        {
+            next       = list->next;
+            list->next = msg;
+            msg        = list;
+            list       = next;
+        }
+    }
+
+    q->out    = msg->next;
+    msg->next = NULL;
+
+    return msg;
+}
+
+bool
+natsMsgQueue_IsEmpty(natsMsgQueue *q)
+{
+    return ((q->out == NULL) && (q->in == NULL));
+}
+
+bool
+natsMsgQueue_Spin(natsMsgQueue *q, int count)
+{
+    int i;
+
+    for (i=0; i<count; i++)
+    {
+        if (q->in != NULL)
+            return true;
+
+        nats_cpuPause();
+    }
+
+    return (q->in != NULL);
+}
+
+bool
+natsMsgQueue_SpinFor(natsMsgQueue *q, int64_t nanos)
+{
+    int64_t end = nats_monotonicNowInNanoSeconds() + nanos;
+
+    // Reading the clock is more expensive than checking the queue.
+    while (!natsMsgQueue_Spin(q, NATS_MSG_QUEUE_SPIN_COUNT))
+    {
+        if (nats_monotonicNowInNanoSeconds() >= end)
+            return false;
+    }
+
+    return true;
+}
+
+void
+natsMsgQueue_Clear(natsMsgQueue *q)
+{
+    natsMsg *msg;
+
+    while ((msg = natsMsgQueue_Pop(q)) != NULL)
+        natsMsg_Destroy(msg);
+}
@@ -19,6 +19,65 @@
 
 struct __natsMsg;
 
+// A block of memory the read loop reads into when zero-copy receive is
+// enabled. Messages fully contained in the block point into it and hold
+// a reference. The read loop holds one too, as long as it uses the block.
+typedef struct __natsMsgSlab
+{
+    natsAtomicInt   refs;
+    int             size;
+    char            *data;
+
+} natsMsgSlab;
+
+// Number of size classes of a message pool. The sizes (that include the
+// natsMsg structure) are 128, 512, 2048 and 8192 bytes. Larger messages
+// are not pooled.
+#define NATS_MSG_POOL_CLASSES   (4)
+
+// Number of stripes messages are returned to, selected by thread index.
+#define NATS_MSG_POOL_STRIPES   (8)
+
+typedef struct __natsMsgPoolStripe
+{
+    natsMutex           *mu;
+    struct __natsMsg    *free[NATS_MSG_POOL_CLASSES];
+    int                 count[NATS_MSG_POOL_CLASSES];
+
+} natsMsgPoolStripe;
+
+// Recycles the memory of the messages created by a connection. Destroyed
+// messages are put back in the stripe selected by the calling thread, so
+// that threads destroying messages rarely contend. The thread creating
+// messages (there is only one at a time for a connection) keeps a private
+// list per size class, refilled in bulk from a stripe when it is empty.
+typedef struct __natsMsgPool
+{
+    // One for the owner, plus one per message allocated from the pool
+    // and not yet returned to it.
+    natsAtomicInt       refs;
+    int                 maxFreePerStripe;
+    struct __natsMsg    *cache[NATS_MSG_POOL_CLASSES];
+    natsMsgPoolStripe   stripes[NATS_MSG_POOL_STRIPES];
+
+} natsMsgPool;
+
+// Number of times a consumer checks for new messages before parking.
+#define NATS_MSG_QUEUE_SPIN_COUNT   (200)
+
+// A queue of messages, linked through their 'next' field. Producers push
+// lists of messages without locking, and may do so concurrently. Only one
+// consumer at a time may pop messages, so consumers must serialize through
+// their own lock. Producers push to the front of 'in', and the consumer
+// takes the whole 'in' list at once, reverses it into 'out', and pops
+// from there.
+typedef struct __natsMsgQueue
+{
+    struct __natsMsg * volatile in;
+    struct __natsMsg            *out;
+
+} natsMsgQueue;
+
 struct __natsMsg
 {
     natsGCItem          gc;
@@ -34,6 +93,14 @@ struct __natsMsg
     // subscription (needed when delivery done by connection)
     struct __natsSubscription *sub;
 
+    // If not NULL, subject, reply and data point into this slab
+    // instead of the memory following this structure.
+    natsMsgSlab         *slab;
+
+    // If not NULL, the message is returned to this pool when freed.
+    natsMsgPool         *pool;
+    int                 poolClass;
+
     // Must be last field!
     struct __natsMsg    *next;
 
@@ -47,6 +114,78 @@ natsMsg_create(natsMsg **newMsg,
                const char *reply, int replyLen,
                const char *buf, int bufLen);
 
+// Same as natsMsg_create, but the memory is taken from 'pool' if possible,
+// in which case 'hit' is set to true.
+natsStatus
+natsMsg_createFromPool(natsMsg **newMsg, natsMsgPool *pool, bool *hit,
+                       const char *subject, int subjLen,
+                       const char *reply, int replyLen,
+                       const char *buf, int bufLen);
+
+// Creates a message whose subject, reply and payload point into 'slab'.
+// The byte following each of them in the slab is overwritten with '\0',
+// so the caller must ensure that those bytes exist and are no longer
+// needed. A reference on the slab is added. The message structure is
+// taken from 'pool' if not NULL, in which case 'hit' is set to true if
+// a free message was available.
+natsStatus
+natsMsg_createFromSlab(natsMsg **newMsg, natsMsgPool *pool, bool *hit,
+                       natsMsgSlab *slab,
+                       char *subject, int subjLen,
+                       char *reply, int replyLen,
+                       char *buf, int bufLen);
+
+natsStatus
+natsMsgSlab_Create(natsMsgSlab **newSlab, int size);
+
+void
+natsMsgSlab_Retain(natsMsgSlab *slab);
+
+// Removes a reference and frees the slab when the count drops to 0.
+void
+natsMsgSlab_Release(natsMsgSlab *slab);
+
+// Creates a message pool that keeps at most 'maxFree' free messages
+// per size class.
+natsStatus
+natsMsgPool_Create(natsMsgPool **newPool, int maxFree);
+
+// Releases the owner's reference. The pool is freed when all messages
+// allocated from it have been destroyed.
+void
+natsMsgPool_Release(natsMsgPool *pool);
+
+// Pushes the list of messages starting at 'head' (linked through their
+// 'next' field) to the queue, preserving their order. Returns true if
+// there was no pushed message that the consumer had not yet taken, in
+// which case the consumer may be parked and need to be woken up.
+bool
+natsMsgQueue_Push(natsMsgQueue *q, struct __natsMsg *head);
+
+// Pops the first message, or returns NULL if the queue is empty.
+struct __natsMsg*
+natsMsgQueue_Pop(natsMsgQueue *q);
+
+bool
+natsMsgQueue_IsEmpty(natsMsgQueue *q);
+
+// Checks up to 'count' times, without blocking, if producers have pushed
+// messages, and returns true as soon as it is the case. Only the producer
+// side is checked, so this can be called without the consumer's lock even
+// if other consumers may pop concurrently. It does not account for the
+// messages already taken by the consumer, so check natsMsgQueue_IsEmpty()
+// first where that matters.
+bool
+natsMsgQueue_Spin(natsMsgQueue *q, int count);
+
+// Same than natsMsgQueue_Spin(), but checks for up to 'nanos' nanoseconds.
+bool
+natsMsgQueue_SpinFor(natsMsgQueue *q, int64_t nanos);
+
+// Destroys all messages in the queue.
+void
+natsMsgQueue_Clear(natsMsgQueue *q);
+
 // This needs to follow the nats_FreeObjectCb prototype (see gc.h)
 void
 natsMsg_free(void *object);
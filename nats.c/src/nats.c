@@ -53,13 +53,27 @@ typedef struct __natsLibTimers
     natsMutex       *lock;
     natsCondition   *cond;
     natsThread      *thread;
-    natsTimer       *timers;
+    natsTimerWheel  wheel;
+    // Number of active timers, including the one in its callback.
     int             count;
     bool            changed;
     bool            shutdown;
 
 } natsLibTimers;
 
+typedef struct __natsLibTimerThreads
+{
+    natsMutex       *lock;
+    // Number of timer threads created.
+    int             size;
+    // Number of threads new timers are assigned to.
+    int             maxSize;
+    // Thread the next timer is assigned to.
+    int             next;
+    natsLibTimers   *threads[NATS_LIB_MAX_TIMER_THREADS];
+
+} natsLibTimerThreads;
+
 typedef struct __natsLibAsyncCbs
 {
     natsMutex       *lock;
@@ -76,7 +90,8 @@ typedef struct __natsGCList
     natsMutex       *lock;
     natsCondition   *cond;
     natsThread      *thread;
-    natsGCItem      *head;
+    // Items are pushed without holding the lock, see natsGC_collect().
+    natsGCItem      * volatile head;
     bool            shutdown;
     bool            inWait;
 
@@ -85,9 +100,13 @@ typedef struct __natsGCList
 typedef struct __natsLibDlvWorkers
 {
     natsMutex           *lock;
-    int                 idx;
+    // Number of workers created.
     int                 size;
+    // Number of active workers. Workers past this index are parked: no
+    // subscription is assigned to them and they don't take work from others.
     int                 maxSize;
+    // Capacity of the 'workers' array.
+    int                 cap;
     natsMsgDlvWorker    **workers;
 
 } natsLibDlvWorkers;
@@ -101,6 +120,9 @@ typedef struct __natsLib
     natsThreadLocal errTLKey;
     natsThreadLocal sslTLKey;
     natsThreadLocal natsThreadKey;
+    natsThreadLocal threadIdxKey;
+    natsThreadLocal inlineDlvKey;
+    int             threadIdxNext;
     bool            initialized;
     bool            closed;
     natsCondition   *closeCompleteCond;
@@ -115,7 +137,7 @@ typedef struct __natsLib
     bool            libHandlingMsgDeliveryByDefault;
     int64_t         libDefaultWriteDeadline;
 
-    natsLibTimers       timers;
+    natsLibTimerThreads timers;
     natsLibAsyncCbs     asyncCbs;
     natsLibDlvWorkers   dlvWorkers;
 
@@ -165,6 +187,8 @@ _finalCleanup(void)
 
     natsThreadLocal_DestroyKey(gLib.errTLKey);
     natsThreadLocal_DestroyKey(gLib.natsThreadKey);
+    natsThreadLocal_DestroyKey(gLib.threadIdxKey);
+    natsThreadLocal_DestroyKey(gLib.inlineDlvKey);
     natsMutex_Destroy(gLib.lock);
     gLib.lock = NULL;
 }
@@ -175,6 +199,42 @@ nats_setNATSThreadKey(void)
     natsThreadLocal_Set(gLib.natsThreadKey, (const void*)1);
 }
 
+int
+nats_getThreadIndex(void)
+{
+    void    *tl = NULL;
+    int     idx = 0;
+
+    // The index is stored incremented by one so that a NULL value
+    // means that no index has been assigned to this thread yet.
+    tl = natsThreadLocal_Get(gLib.threadIdxKey);
+    if (tl != NULL)
+        return (int) (((intptr_t) tl) - 1);
+
+    natsMutex_Lock(gLib.lock);
+    idx = gLib.threadIdxNext++;
+    if (gLib.threadIdxNext < 0)
+        gLib.threadIdxNext = 0;
+    natsMutex_Unlock(gLib.lock);
+
+    natsThreadLocal_SetEx(gLib.threadIdxKey, (const void*) (((intptr_t) idx) + 1), false);
+
+    return idx;
+}
+
+void
+nats_setInlineDeliveryConn(natsConnection *nc)
+{
+    natsThreadLocal_SetEx(gLib.inlineDlvKey, (const void*) nc, false);
+}
+
+bool
+nats_isInlineDeliveryConn(natsConnection *nc)
+{
+    return ((nc != NULL)
+            && (natsThreadLocal_Get(gLib.inlineDlvKey) == (void*) nc));
+}
+
 void
 nats_ReleaseThreadMemory(void)
 {
@@ -267,13 +327,26 @@ natsLib_Destructor(void)
 }
 
 static void
-_freeTimers(void)
+_freeTimerThread(natsLibTimers *timers)
 {
-    natsLibTimers *timers = &(gLib.timers);
-
     natsThread_Destroy(timers->thread);
     natsCondition_Destroy(timers->cond);
     natsMutex_Destroy(timers->lock);
+    NATS_FREE(timers);
+}
+
+static void
+_freeTimers(void)
+{
+    natsLibTimerThreads *pool = &(gLib.timers);
+    int                 i;
+
+    for (i=0; i<pool->size; i++)
+        _freeTimerThread(pool->threads[i]);
+
+    natsMutex_Destroy(pool->lock);
+    pool->size    = 0;
+    pool->maxSize = 0;
 }
 
 static void
@@ -301,6 +374,7 @@ _freeDlvWorker(natsMsgDlvWorker *worker)
 {
     natsThread_Destroy(worker->thread);
     natsCondition_Destroy(worker->cond);
+    natsMutex_Destroy(worker->runLock);
     natsMutex_Destroy(worker->lock);
     NATS_FREE(worker);
 }
@@ -316,8 +390,8 @@ _freeDlvWorkers(void)
 
     NATS_FREE(workers->workers);
     natsMutex_Destroy(workers->lock);
-    workers->idx     = 0;
     workers->size    = 0;
+    workers->cap     = 0;
     workers->workers = NULL;
 }
 
@@ -396,6 +470,10 @@ _doInitOnce(void)
         s = natsThreadLocal_CreateKey(&(gLib.errTLKey), _destroyErrTL);
     if (s == NATS_OK)
         s = natsThreadLocal_CreateKey(&(gLib.natsThreadKey), NULL);
+    if (s == NATS_OK)
+        s = natsThreadLocal_CreateKey(&(gLib.threadIdxKey), NULL);
+    if (s == NATS_OK)
+        s = natsThreadLocal_CreateKey(&(gLib.inlineDlvKey), NULL);
     if (s != NATS_OK)
     {
         fprintf(stderr, "FATAL ERROR: Unable to initialize library!\n");
@@ -409,38 +487,6 @@ _doInitOnce(void)
     atexit(natsLib_Destructor);
 }
 
-static void
-_insertTimer(natsTimer *t)
-{
-    natsTimer *cur  = gLib.timers.timers;
-    natsTimer *prev = NULL;
-
-    while ((cur != NULL) && (cur->absoluteTime <= t->absoluteTime))
-    {
-        prev = cur;
-        cur  = cur->next;
-    }
-
-    if (cur != NULL)
-    {
-        t->prev = prev;
-        t->next = cur;
-        cur->prev = t;
-
-        if (prev != NULL)
-            prev->next = t;
-    }
-    else if (prev != NULL)
-    {
-        prev->next = t;
-        t->prev = prev;
-        t->next = NULL;
-    }
-
-    if (prev == NULL)
-        gLib.timers.timers = t;
-}
-
 // Locks must be held before entering this function
 static void
 _removeTimer(natsLibTimers *timers, natsTimer *t)
@@ -449,29 +495,33 @@ _removeTimer(natsLibTimers *timers, natsTimer *t)
     t->stopped = true;
 
     // It the timer was in the callback, it has already been removed from the
-    // list, so skip that.
+    // wheel, so skip that.
     if (!(t->inCallback))
-    {
-        if (t->prev != NULL)
-            t->prev->next = t->next;
-        if (t->next != NULL)
-            t->next->prev = t->prev;
+        natsTimerWheel_Remove(&(timers->wheel), t);
 
-        if (t == gLib.timers.timers)
-            gLib.timers.timers = t->next;
+    // Decrease the thread's count of timers
+    timers->count--;
+}
 
-        t->prev = NULL;
-        t->next = NULL;
-    }
+void
+nats_assignTimer(natsTimer *t)
+{
+    natsLibTimerThreads *pool = &(gLib.timers);
 
-    // Decrease the global count of timers
-    timers->count--;
+    natsMutex_Lock(pool->lock);
+
+    // Spread the timers over the threads, since they are not moved once
+    // assigned.
+    t->owner   = pool->threads[pool->next];
+    pool->next = (pool->next + 1) % pool->maxSize;
+
+    natsMutex_Unlock(pool->lock);
 }
 
 void
 nats_resetTimer(natsTimer *t, int64_t newInterval)
 {
-    natsLibTimers *timers = &(gLib.timers);
+    natsLibTimers *timers = t->owner;
 
     natsMutex_Lock(timers->lock);
     natsMutex_Lock(t->mu);
@@ -495,8 +545,8 @@ nats_resetTimer(natsTimer *t, int64_t newInterval)
     // the timer's callback.
     if (!(t->inCallback))
     {
-        t->absoluteTime = nats_Now() + t->interval;
-        _insertTimer(t);
+        t->absoluteTime = nats_monotonicNow() + t->interval;
+        natsTimerWheel_Add(&(timers->wheel), t);
     }
 
     natsMutex_Unlock(t->mu);
@@ -512,7 +562,7 @@ nats_resetTimer(natsTimer *t, int64_t newInterval)
 void
 nats_stopTimer(natsTimer *t)
 {
-    natsLibTimers   *timers = &(gLib.timers);
+    natsLibTimers   *timers = t->owner;
     bool            doCb    = false;
 
     natsMutex_Lock(timers->lock);
@@ -547,13 +597,20 @@ nats_stopTimer(natsTimer *t)
 int
 nats_getTimersCount(void)
 {
-    int         count = 0;
+    natsLibTimerThreads *pool   = &(gLib.timers);
+    int                 count   = 0;
+    int                 i;
 
-    natsMutex_Lock(gLib.timers.lock);
+    natsMutex_Lock(pool->lock);
 
-    count = gLib.timers.count;
+    for (i=0; i<pool->size; i++)
+    {
+        natsMutex_Lock(pool->threads[i]->lock);
+        count += pool->threads[i]->count;
+        natsMutex_Unlock(pool->threads[i]->lock);
+    }
 
-    natsMutex_Unlock(gLib.timers.lock);
+    natsMutex_Unlock(pool->lock);
 
     return count;
 }
@@ -561,19 +618,20 @@ nats_getTimersCount(void)
 int
 nats_getTimersCountInList(void)
 {
-    int         count = 0;
-    natsTimer   *t;
+    natsLibTimerThreads *pool   = &(gLib.timers);
+    int                 count   = 0;
+    int                 i;
 
-    natsMutex_Lock(gLib.timers.lock);
+    natsMutex_Lock(pool->lock);
 
-    t = gLib.timers.timers;
-    while (t != NULL)
+    for (i=0; i<pool->size; i++)
     {
-        count++;
-        t = t->next;
+        natsMutex_Lock(pool->threads[i]->lock);
+        count += pool->threads[i]->wheel.count;
+        natsMutex_Unlock(pool->threads[i]->lock);
     }
 
-    natsMutex_Unlock(gLib.timers.lock);
+    natsMutex_Unlock(pool->lock);
 
     return count;
 }
@@ -582,7 +640,7 @@ nats_getTimersCountInList(void)
 static void
 _timerThread(void *arg)
 {
-    natsLibTimers   *timers = &(gLib.timers);
+    natsLibTimers   *timers = (natsLibTimers*) arg;
     natsTimer       *t      = NULL;
     natsStatus      s       = NATS_OK;
     bool            doStopCb;
@@ -594,47 +652,31 @@ _timerThread(void *arg)
 
     while (!(timers->shutdown))
     {
-        // Take the first timer that needs to fire.
-        t = timers->timers;
+        // Take a timer that needs to fire.
+        t = natsTimerWheel_PopExpired(&(timers->wheel), nats_monotonicNow());
 
         if (t == NULL)
         {
             // No timer, fire in an hour...
-            target = nats_Now() + 3600 * 1000;
-        }
-        else
-        {
-            target = t->absoluteTime;
-        }
+            if (!natsTimerWheel_NextTick(&(timers->wheel), &target))
+                target = nats_monotonicNow() + 3600 * 1000;
 
-        timers->changed = false;
+            timers->changed = false;
 
-        s = NATS_OK;
+            s = NATS_OK;
 
-        while (!(timers->shutdown)
-               && (s != NATS_TIMEOUT)
-               && !(timers->changed))
-        {
-            s = natsCondition_AbsoluteTimedWait(timers->cond, timers->lock,
-                                                target);
-        }
-
-        if (timers->shutdown)
-            break;
-
-        if ((t == NULL) || timers->changed)
+            while (!(timers->shutdown)
+                   && (s != NATS_TIMEOUT)
+                   && !(timers->changed))
+            {
+                s = natsCondition_AbsoluteTimedWait(timers->cond, timers->lock,
+                                                    target);
+            }
             continue;
+        }
 
         natsMutex_Lock(t->mu);
 
-        // Remove timer from the list:
-        timers->timers = t->next;
-        if (t->next != NULL)
-            t->next->prev = NULL;
-
-        t->prev = NULL;
-        t->next = NULL;
-
         t->inCallback = true;
 
         // Retain the timer, since we are going to release the locks for the
@@ -656,15 +698,15 @@ _timerThread(void *arg)
         // the window the locks were released.
         doStopCb = (t->stopped && (t->stopCb != NULL));
 
-        // If not stopped, we need to put it back in our list
-        if (!doStopCb)
+        // If not stopped, we need to put it back in the wheel
+        if (!(t->stopped))
         {
             // Reset our view of what is the time this timer should fire
             // because:
             // 1- the callback may have taken longer than it should
             // 2- the user may have called Reset() with a new interval
-            t->absoluteTime = nats_Now() + t->interval;
-            _insertTimer(t);
+            t->absoluteTime = nats_monotonicNow() + t->interval;
+            natsTimerWheel_Add(&(timers->wheel), t);
         }
 
         natsMutex_Unlock(t->mu);
@@ -680,20 +722,20 @@ _timerThread(void *arg)
         natsMutex_Lock(timers->lock);
     }
 
-    // Process the timers that were left in the list (not stopped) when the
+    // Process the timers that were left in the wheel (not stopped) when the
     // library is shutdown.
-    while ((t = timers->timers) != NULL)
+    while ((t = natsTimerWheel_First(&(timers->wheel))) != NULL)
     {
         natsMutex_Lock(t->mu);
 
         // Check if we should invoke the callback. Note that although we are
-        // releasing the locks below, a timer present in the list here is
+        // releasing the locks below, a timer present in the wheel here is
         // guaranteed not to have been stopped (because it would not be in
-        // the list otherwise, since there is no chance that it is in the
+        // the wheel otherwise, since there is no chance that it is in the
         // timer's callback). So just check if there is a stopCb to invoke.
         doStopCb = (t->stopCb != NULL);
 
-        // Remove the timer from the list.
+        // Remove the timer from the wheel.
         _removeTimer(timers, t);
 
         natsMutex_Unlock(t->mu);
@@ -714,6 +756,38 @@ _timerThread(void *arg)
     natsLib_Release();
 }
 
+// Creates a timer thread. This must be called with the library's and the
+// pool's locks held.
+static natsStatus
+_createTimerThread(void)
+{
+    natsStatus          s       = NATS_OK;
+    natsLibTimerThreads *pool   = &(gLib.timers);
+    natsLibTimers       *timers = NULL;
+
+    timers = NATS_CALLOC(1, sizeof(natsLibTimers));
+    if (timers == NULL)
+        return nats_setDefaultError(NATS_NO_MEMORY);
+
+    natsTimerWheel_Init(&(timers->wheel), nats_monotonicNow());
+
+    s = natsMutex_Create(&(timers->lock));
+    if (s == NATS_OK)
+        s = natsCondition_Create(&(timers->cond));
+    if (s == NATS_OK)
+    {
+        s = natsThread_Create(&(timers->thread), _timerThread, (void*) timers);
+        if (s == NATS_OK)
+            gLib.refs++;
+    }
+    if (s == NATS_OK)
+        pool->threads[pool->size++] = timers;
+    else
+        _freeTimerThread(timers);
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
 static void
 _asyncCbsThread(void *arg)
 {
@@ -768,6 +842,12 @@ _asyncCbsThread(void *arg)
             case ASYNC_DISCOVERED_SERVERS:
                 (*(nc->opts->discoveredServersCb))(nc, nc->opts->discoveredServersClosure);
                 break;
+            case ASYNC_OUTBOUND_HIGH:
+                (*(nc->opts->outboundHighCb))(nc, nc->opts->outboundHighCbClosure);
+                break;
+            case ASYNC_OUTBOUND_LOW:
+                (*(nc->opts->outboundLowCb))(nc, nc->opts->outboundLowCbClosure);
+                break;
             case ASYNC_ERROR:
                 (*(nc->opts->asyncErrCb))(nc, cb->sub, cb->err, nc->opts->asyncErrCbClosure);
                 break;
@@ -845,20 +925,15 @@ _garbageCollector(void *closure)
         // signaling when an item is added to the collector.
         gc->inWait = false;
 
+        natsMutex_Unlock(gc->lock);
+
         // Do not break out on shutdown here, we want to clear the list,
         // even on exit so that valgrind and the like are happy.
 
-        // Under the lock, we will switch to a local list and reset the
-        // GC's list (so that others can add to the list without contention
-        // (at least from the GC itself).
-        do
+        // Take the whole list at once. Others keep on adding to the
+        // (now empty) list without contention.
+        while ((list = (natsGCItem*) nats_atomicSwapPtr(&(gc->head), NULL)) != NULL)
         {
-            list = gc->head;
-            gc->head = NULL;
-
-            natsMutex_Unlock(gc->lock);
-
-            // Now that we are outside of the lock, we can empty the list.
             while ((item = list) != NULL)
             {
                 // Pops item from the beginning of the list.
@@ -868,13 +943,12 @@ _garbageCollector(void *closure)
                 // Invoke the freeCb associated with this object
                 (*(item->freeCb))((void*) item);
             }
-
-            natsMutex_Lock(gc->lock);
         }
-        while (gc->head != NULL);
+
+        natsMutex_Lock(gc->lock);
 
         // If we were ask to shutdown and since the list is now empty, exit
-        if (gc->shutdown)
+        if (gc->shutdown && (gc->head == NULL))
             break;
     }
 
@@ -887,7 +961,7 @@ bool
 natsGC_collect(natsGCItem *item)
 {
     natsGCList  *gc;
-    bool        signal;
+    natsGCItem  *head;
 
     // If the object was not setup for garbage collection, return false
     // so the caller frees the object.
@@ -896,21 +970,26 @@ natsGC_collect(natsGCItem *item)
 
     gc = &(gLib.gc);
 
-    natsMutex_Lock(gc->lock);
-
-    // We will signal only if the GC is in the condition wait.
-    signal = gc->inWait;
-
-    // Add to the front of the list.
-    item->next = gc->head;
+    // Add to the front of the list without locking.
+    do
+    {
+        head = gc->head;
+        item->next = head;
+    }
+    while (!nats_atomicCASPtr(&(gc->head), head, item));
 
-    // Update head.
-    gc->head = item;
+    // Only the thread that makes the list non empty may have to wake up
+    // the GC. If the list was not empty, the GC has either been signaled
+    // already, or will find this item after processing its current list.
+    if (head == NULL)
+    {
+        natsMutex_Lock(gc->lock);
 
-    if (signal)
-        natsCondition_Signal(gc->cond);
+        if (gc->inWait)
+            natsCondition_Signal(gc->cond);
 
-    natsMutex_Unlock(gc->lock);
+        natsMutex_Unlock(gc->lock);
+    }
 
     return true;
 }
@@ -927,8 +1006,12 @@ _libTearDown(void)
             natsThread_Join(worker->thread);
     }
 
-    if (gLib.timers.thread != NULL)
-        natsThread_Join(gLib.timers.thread);
+    for (i=0; i<gLib.timers.size; i++)
+    {
+        natsLibTimers *timers = gLib.timers.threads[i];
+        if (timers->thread != NULL)
+            natsThread_Join(timers->thread);
+    }
 
     if (gLib.asyncCbs.thread != NULL)
         natsThread_Join(gLib.asyncCbs.thread);
@@ -943,6 +1026,7 @@ natsStatus
 nats_Open(int64_t lockSpinCount)
 {
     natsStatus s = NATS_OK;
+    int        i;
 
     if (!nats_InitOnce(&gInitOnce, _doInitOnce))
         return NATS_FAILED_TO_INITIALIZE;
@@ -984,13 +1068,10 @@ nats_Open(int64_t lockSpinCount)
 
     if (s == NATS_OK)
         s = natsMutex_Create(&(gLib.timers.lock));
-    if (s == NATS_OK)
-        s = natsCondition_Create(&(gLib.timers.cond));
     if (s == NATS_OK)
     {
-        s = natsThread_Create(&(gLib.timers.thread), _timerThread, NULL);
-        if (s == NATS_OK)
-            gLib.refs++;
+        gLib.timers.maxSize = 1;
+        s = _createTimerThread();
     }
 
     if (s == NATS_OK)
@@ -1027,7 +1108,8 @@ nats_Open(int64_t lockSpinCount)
 
         gLib.libHandlingMsgDeliveryByDefault = (getenv("NATS_DEFAULT_TO_LIB_MSG_DELIVERY") != NULL ? true : false);
         gLib.dlvWorkers.maxSize = 2;
-        gLib.dlvWorkers.workers = NATS_CALLOC(gLib.dlvWorkers.maxSize, sizeof(natsMsgDlvWorker*));
+        gLib.dlvWorkers.cap     = 2;
+        gLib.dlvWorkers.workers = NATS_CALLOC(gLib.dlvWorkers.cap, sizeof(natsMsgDlvWorker*));
         if (gLib.dlvWorkers.workers == NULL)
             s = NATS_NO_MEMORY;
     }
@@ -1042,7 +1124,8 @@ nats_Open(int64_t lockSpinCount)
         if (s != NATS_OK)
         {
             gLib.initAborted = true;
-            gLib.timers.shutdown = true;
+            for (i=0; i<gLib.timers.size; i++)
+                gLib.timers.threads[i]->shutdown = true;
             gLib.asyncCbs.shutdown = true;
             gLib.gc.shutdown = true;
         }
@@ -1157,8 +1240,14 @@ _close(bool wait, int64_t timeout)
     gLib.closed = true;
 
     natsMutex_Lock(gLib.timers.lock);
-    gLib.timers.shutdown = true;
-    natsCondition_Signal(gLib.timers.cond);
+    for (i=0; i<gLib.timers.size; i++)
+    {
+        natsLibTimers *timers = gLib.timers.threads[i];
+        natsMutex_Lock(timers->lock);
+        timers->shutdown = true;
+        natsCondition_Signal(timers->cond);
+        natsMutex_Unlock(timers->lock);
+    }
     natsMutex_Unlock(gLib.timers.lock);
 
     natsMutex_Lock(gLib.asyncCbs.lock);
@@ -1175,10 +1264,10 @@ _close(bool wait, int64_t timeout)
     for (i=0; i<gLib.dlvWorkers.size; i++)
     {
         natsMsgDlvWorker *worker = gLib.dlvWorkers.workers[i];
-        natsMutex_Lock(worker->lock);
+        natsMutex_Lock(worker->runLock);
         worker->shutdown = true;
         natsCondition_Signal(worker->cond);
-        natsMutex_Unlock(worker->lock);
+        natsMutex_Unlock(worker->runLock);
     }
     natsMutex_Unlock(gLib.dlvWorkers.lock);
 
@@ -1624,45 +1713,140 @@ nats_sslInit(void)
     return NATS_UPDATE_ERR_STACK(s);
 }
 
+// Appends the subscription to the worker's run queue. This must be called
+// with the worker's 'runLock' held.
 static void
-_deliverMsgs(void *arg)
+_pushRunQueue(natsMsgDlvWorker *dlv, natsSubscription *sub)
 {
-    natsMsgDlvWorker    *dlv = (natsMsgDlvWorker*) arg;
+    sub->dlvNext = NULL;
+
+    if (dlv->runTail == NULL)
+        dlv->runHead = sub;
+    else
+        dlv->runTail->dlvNext = sub;
+
+    dlv->runTail = sub;
+    dlv->runLen++;
+}
+
+// Removes the first subscription of the worker's run queue. This must be
+// called with the worker's 'runLock' held.
+static natsSubscription*
+_popRunQueue(natsMsgDlvWorker *dlv)
+{
+    natsSubscription *sub = dlv->runHead;
+
+    if (sub == NULL)
+        return NULL;
+
+    dlv->runHead = sub->dlvNext;
+    if (dlv->runHead == NULL)
+        dlv->runTail = NULL;
+
+    sub->dlvNext = NULL;
+    dlv->runLen--;
+
+    return sub;
+}
+
+// Number of subscriptions the worker has to go through before being able
+// to deliver a newly queued one.
+#define _dlvWorkerLoad(w) ((w)->runLen + ((w)->running ? 1 : 0))
+
+// A worker is idle if it waits for work. Like the load, this is read
+// without the worker's lock and is only a hint.
+#define _dlvWorkerIsIdle(w) (((w)->inWait > 0) && ((w)->runLen == 0) && !((w)->running))
+
+// Changes the worker in which run queue the subscription is added when
+// it has messages to deliver. This must be called by the thread that has
+// scheduled the subscription or taken it from a run queue, so that no
+// other thread is delivering its messages.
+static void
+_setDlvHome(natsSubscription *sub, natsMsgDlvWorker *dlv)
+{
+    natsMsgDlvWorker *home = sub->dlvHome;
+
+    if (home == dlv)
+        return;
+
+    if (!sub->dlvDone)
+    {
+        nats_atomicDec(&(home->numSubs));
+        nats_atomicInc(&(dlv->numSubs));
+    }
+    sub->dlvHome = dlv;
+}
+
+// Takes a subscription from the run queue of the busiest worker, if any,
+// and makes this worker its home. Parked workers don't take work from
+// others.
+static natsSubscription*
+_stealSub(natsMsgDlvWorker *dlv)
+{
+    natsLibDlvWorkers   *workers = &(gLib.dlvWorkers);
+    natsMsgDlvWorker    *victim  = NULL;
+    natsSubscription    *sub     = NULL;
+    int                 best     = 0;
+    int                 i;
+
+    natsMutex_Lock(workers->lock);
+
+    for (i=0; (dlv->idx < workers->maxSize) && (i<workers->size); i++)
+    {
+        natsMsgDlvWorker    *w = workers->workers[i];
+        int                 n;
+
+        if (w == dlv)
+            continue;
+
+        // A worker that is not delivering is about to take the first
+        // subscription of its queue.
+        n = w->runLen;
+        if (!w->running)
+            n--;
+
+        if (n > best)
+        {
+            best   = n;
+            victim = w;
+        }
+    }
+    if (victim != NULL)
+    {
+        natsMutex_Lock(victim->runLock);
+        sub = _popRunQueue(victim);
+        natsMutex_Unlock(victim->runLock);
+    }
+
+    natsMutex_Unlock(workers->lock);
+
+    if (sub != NULL)
+        _setDlvHome(sub, dlv);
+
+    return sub;
+}
+
+// Delivers up to NATS_LIB_DLV_QUANTUM messages of this subscription.
+// Returns the number of messages that have been processed.
+static int
+_deliverSubMsgs(natsSubscription *sub)
+{
+    natsMsgDlvWorker    *ldw = sub->libDlvWorker;
     natsConnection      *nc;
-    natsSubscription    *sub;
     natsMsgHandler      mcb;
     void                *mcbClosure;
     uint64_t            delivered;
     uint64_t            max;
     natsMsg             *msg;
     bool                timerNeedReset = false;
-    bool                removeSub = false;
+    int                 count = 0;
 
-    natsMutex_Lock(dlv->lock);
+    natsMutex_Lock(ldw->lock);
 
-    while (true)
+    while ((count < NATS_LIB_DLV_QUANTUM)
+           && ((msg = natsMsgQueue_Pop(&(sub->msgQ))) != NULL))
     {
-        while (((msg = dlv->msgList.head) == NULL) && !dlv->shutdown)
-        {
-            dlv->inWait = true;
-            natsCondition_Wait(dlv->cond, dlv->lock);
-            dlv->inWait = false;
-        }
-
-        // Break out only when list is empty
-        if ((msg == NULL) && dlv->shutdown)
-        {
-            break;
-        }
-
-        // Remove message from list now...
-        dlv->msgList.head = msg->next;
-        if (dlv->msgList.tail == msg)
-            dlv->msgList.tail = NULL;
-        msg->next = NULL;
-
-        // Get subscription reference from message
-        sub = msg->sub;
+        count++;
 
         // Capture these under lock
         nc = sub->conn;
@@ -1682,7 +1866,7 @@ _deliverMsgs(void *arg)
                 sub->libDlvDraining = false;
 
             // We need to release this lock...
-            natsMutex_Unlock(dlv->lock);
+            natsMutex_Unlock(ldw->lock);
 
             // Release the message
             natsMsg_Destroy(msg);
@@ -1708,7 +1892,14 @@ _deliverMsgs(void *arg)
                 if (cb != NULL)
                     (*cb)(closure);
 
-                // Subscription closed, just release
+                if (!sub->dlvDone)
+                {
+                    sub->dlvDone = true;
+                    nats_atomicDec(&(sub->dlvHome->numSubs));
+                }
+
+                // Subscription closed, just release. The caller still
+                // holds a reference for the time it is scheduled.
                 natsSub_release(sub);
             }
             else if (timedOut)
@@ -1718,14 +1909,15 @@ _deliverMsgs(void *arg)
             }
 
             // Grab the lock, we go back to beginning of loop.
-            natsMutex_Lock(dlv->lock);
+            natsMutex_Lock(ldw->lock);
 
             if (!draining && !closed && timedOut)
             {
                 // Reset the timedOut boolean to allow for the
                 // subscription to timeout again, and reset the
                 // timer to fire again starting from now.
-                sub->timedOut = false;
+                sub->timedOut     = false;
+                sub->lastActivity = nats_coarseNow();
                 natsTimer_Reset(sub->timeoutTimer, sub->timeout);
             }
 
@@ -1734,8 +1926,8 @@ _deliverMsgs(void *arg)
         }
 
         // Update before checking closed state.
-        sub->msgList.msgs--;
-        sub->msgList.bytes -= msg->dataLen;
+        nats_atomicDec(&(sub->pendingMsgs));
+        nats_atomicAdd(&(sub->pendingBytes), -(msg->dataLen));
 
         // Need to check for closed subscription again here.
         // The subscription could have been unsubscribed from a callback
@@ -1758,11 +1950,11 @@ _deliverMsgs(void *arg)
 
             // If we are dealing with the last pending message for this sub,
             // we will reset the timer after the user callback returns.
-            if (sub->msgList.msgs == 0)
+            if (nats_atomicGet(&(sub->pendingMsgs)) == 0)
                 timerNeedReset = true;
         }
 
-        natsMutex_Unlock(dlv->lock);
+        natsMutex_Unlock(ldw->lock);
 
         if ((max == 0) || (delivered <= max))
         {
@@ -1782,26 +1974,119 @@ _deliverMsgs(void *arg)
             natsConn_removeSubscription(nc, sub);
         }
 
-        natsMutex_Lock(dlv->lock);
+        natsMutex_Lock(ldw->lock);
 
         // Check if timer need to be reset for subscriptions that can timeout.
         if (!sub->closed && (sub->timeout != 0) && timerNeedReset)
         {
             timerNeedReset = false;
 
-            // Do this only on timer reset instead of after each return
-            // from callback. The reason is that if there are still pending
-            // messages for this subscription (this is the case otherwise
-            // timerNeedReset would be false), we should prevent
-            // the subscription to timeout anyway.
+            // Do this only when the last pending message has been delivered
+            // instead of after each return from callback. The reason is that
+            // if there are still pending messages for this subscription (this
+            // is the case otherwise timerNeedReset would be false), we should
+            // prevent the subscription to timeout anyway.
             sub->timeoutSuspended = false;
 
-            // Reset the timer to fire in `timeout` from now.
-            natsTimer_Reset(sub->timeoutTimer, sub->timeout);
+            // The timeout now starts from here. The timer is not reset, it
+            // will re-arm itself when it fires (see _asyncTimeoutCb()).
+            sub->lastActivity = nats_coarseNow();
+        }
+    }
+
+    natsMutex_Unlock(ldw->lock);
+
+    return count;
+}
+
+static void
+_deliverMsgs(void *arg)
+{
+    natsMsgDlvWorker    *dlv = (natsMsgDlvWorker*) arg;
+    natsSubscription    *sub;
+    bool                stolen;
+    bool                requeue;
+    int64_t             start;
+    int                 count;
+    int                 i;
+
+    natsMutex_Lock(dlv->runLock);
+
+    while (true)
+    {
+        stolen = false;
+
+        sub = _popRunQueue(dlv);
+        if ((sub == NULL) && !dlv->shutdown)
+        {
+            natsMutex_Unlock(dlv->runLock);
+
+            // Nothing to do, see if a busy worker has subscriptions
+            // waiting in its queue.
+            sub = _stealSub(dlv);
+            stolen = (sub != NULL);
+
+            // Otherwise spin for a bit before possibly parking, which
+            // saves producers from having to signal.
+            for (i=0; (sub == NULL) && (i<NATS_MSG_QUEUE_SPIN_COUNT) && (dlv->runLen == 0); i++)
+                nats_cpuPause();
+
+            natsMutex_Lock(dlv->runLock);
+        }
+
+        while ((sub == NULL)
+               && ((sub = _popRunQueue(dlv)) == NULL)
+               && !dlv->shutdown)
+        {
+            dlv->inWait++;
+            natsCondition_Wait(dlv->cond, dlv->runLock);
+            dlv->inWait--;
+        }
+
+        // Break out only when the run queue is empty
+        if ((sub == NULL) && dlv->shutdown)
+            break;
+
+        if (stolen)
+            dlv->steals++;
+
+        dlv->running = true;
+
+        natsMutex_Unlock(dlv->runLock);
+
+        start = nats_monotonicNowInNanoSeconds();
+        count = _deliverSubMsgs(sub);
+
+        if (!natsMsgQueue_IsEmpty(&(sub->msgQ)))
+        {
+            // Give a chance to the other subscriptions of this worker.
+            requeue = true;
         }
+        else
+        {
+            nats_atomicDec(&(sub->dlvScheduled));
+
+            // A producer may have pushed messages after the check above
+            // and seen the subscription as still scheduled.
+            requeue = (!natsMsgQueue_IsEmpty(&(sub->msgQ))
+                       && nats_atomicCAS(&(sub->dlvScheduled), 0, 1));
+
+            // Release the reference added when it was scheduled.
+            if (!requeue)
+                natsSub_release(sub);
+        }
+
+        natsMutex_Lock(dlv->runLock);
+
+        dlv->running    = false;
+        dlv->busyTime  += (nats_monotonicNowInNanoSeconds() - start);
+        dlv->delivered += (uint64_t) count;
+
+        if (requeue)
+            _pushRunQueue(dlv, sub);
     }
 
-    natsMutex_Unlock(dlv->lock);
+    natsMutex_Unlock(dlv->runLock);
 
     natsLib_Release();
 }
@@ -1827,9 +2112,7 @@ nats_SetMessageDeliveryPoolSize(int max)
         return nats_setError(NATS_ERR, "%s", "Pool size cannot be negative or zero");
     }
 
-    // Do not error on max < workers->maxSize in case we allow shrinking
-    // the pool in the future.
-    if (max > workers->maxSize)
+    if (max > workers->cap)
     {
         natsMsgDlvWorker **newArray = NATS_CALLOC(max, sizeof(natsMsgDlvWorker*));
         if (newArray == NULL)
@@ -1842,45 +2125,144 @@ nats_SetMessageDeliveryPoolSize(int max)
 
             NATS_FREE(workers->workers);
             workers->workers = newArray;
-            workers->maxSize = max;
+            workers->cap     = max;
         }
     }
+    // When shrinking, the workers past the new size are parked: they
+    // deliver what is already in their queue, and their subscriptions
+    // move to active workers the next time they have messages.
+    if (s == NATS_OK)
+        workers->maxSize = max;
 
     natsMutex_Unlock(workers->lock);
 
     return NATS_UPDATE_ERR_STACK(s);
 }
 
-// Post a control message to the worker's queue.
+// Picks the worker in which run queue a subscription whose home is busy
+// or parked should be added. This must be called with the pool's lock
+// held.
+static natsMsgDlvWorker*
+_pickDlvWorker(natsLibDlvWorkers *workers, natsMsgDlvWorker *home)
+{
+    natsMsgDlvWorker    *best = NULL;
+    int                 i;
+
+    if ((home->idx < workers->maxSize) && (_dlvWorkerLoad(home) == 0))
+        return home;
+
+    for (i=0; (i<workers->maxSize) && (i<workers->size); i++)
+    {
+        natsMsgDlvWorker *w = workers->workers[i];
+
+        if (_dlvWorkerIsIdle(w))
+            return w;
+
+        if ((best == NULL) || (_dlvWorkerLoad(w) < _dlvWorkerLoad(best)))
+            best = w;
+    }
+    // Stay with the home worker unless it is parked.
+    if ((home->idx < workers->maxSize) || (best == NULL))
+        return home;
+
+    return best;
+}
+
+void
+natsLib_msgDeliverySchedule(natsSubscription *sub)
+{
+    natsLibDlvWorkers   *workers = &(gLib.dlvWorkers);
+    natsMsgDlvWorker    *home    = NULL;
+    natsMsgDlvWorker    *dlv     = NULL;
+
+    // If it is already scheduled, the worker will check the queue again
+    // before clearing the flag.
+    if ((nats_atomicGet(&(sub->dlvScheduled)) != 0)
+        || !nats_atomicCAS(&(sub->dlvScheduled), 0, 1))
+    {
+        return;
+    }
+
+    // Released by the worker when done with the subscription.
+    natsSub_retain(sub);
+
+    home = sub->dlvHome;
+    dlv  = home;
+
+    // Look for another worker only if the home one can't deliver right
+    // away. The subscription then moves to that worker.
+    if ((home->idx >= workers->maxSize) || (_dlvWorkerLoad(home) > 0))
+    {
+        natsMutex_Lock(workers->lock);
+        dlv = _pickDlvWorker(workers, home);
+        natsMutex_Unlock(workers->lock);
+
+        _setDlvHome(sub, dlv);
+    }
+
+    natsMutex_Lock(dlv->runLock);
+    _pushRunQueue(dlv, sub);
+    if (dlv->inWait > 0)
+        natsCondition_Signal(dlv->cond);
+    natsMutex_Unlock(dlv->runLock);
+}
+
+// Post a control message to the subscription's queue.
 natsStatus
 natsLib_msgDeliveryPostControlMsg(natsSubscription *sub)
 {
     natsStatus          s;
     natsMsg             *controlMsg = NULL;
-    natsMsgDlvWorker    *worker = (sub->libDlvWorker);
 
     // Create a "end" message and post it to the delivery worker
     s = natsMsg_create(&controlMsg, NULL, 0, NULL, 0, NULL, 0);
     if (s == NATS_OK)
     {
-        natsMsgList *l;
+        (void) natsMsgQueue_Push(&(sub->msgQ), controlMsg);
+        natsLib_msgDeliverySchedule(sub);
+    }
+    return NATS_UPDATE_ERR_STACK(s);
+}
 
-        natsMutex_Lock(worker->lock);
+// Creates the worker at this index in the pool. This must be called with
+// the pool's lock held.
+static natsStatus
+_createDlvWorker(natsMsgDlvWorker **newWorker, int idx)
+{
+    natsStatus          s = NATS_OK;
+    natsLibDlvWorkers   *workers = &(gLib.dlvWorkers);
+    natsMsgDlvWorker    *worker = NULL;
 
-        controlMsg->sub = sub;
+    worker = NATS_CALLOC(1, sizeof(natsMsgDlvWorker));
+    if (worker == NULL)
+        return nats_setDefaultError(NATS_NO_MEMORY);
 
-        l = &(worker->msgList);
-        if (l->tail != NULL)
-            l->tail->next = controlMsg;
-        if (l->head == NULL)
-            l->head = controlMsg;
-        l->tail = controlMsg;
+    worker->idx = idx;
 
-        if (worker->inWait)
-            natsCondition_Signal(worker->cond);
+    s = natsMutex_Create(&worker->lock);
+    if (s == NATS_OK)
+        s = natsMutex_Create(&worker->runLock);
+    if (s == NATS_OK)
+        s = natsCondition_Create(&worker->cond);
+    if (s == NATS_OK)
+    {
+        natsLib_Retain();
+        s = natsThread_Create(&worker->thread, _deliverMsgs, (void*) worker);
+        if (s != NATS_OK)
+            natsLib_Release();
+    }
+    if (s == NATS_OK)
+    {
+        workers->workers[idx] = worker;
+        workers->size++;
 
-        natsMutex_Unlock(worker->lock);
+        *newWorker = worker;
+    }
+    else
+    {
+        _freeDlvWorker(worker);
     }
+
     return NATS_UPDATE_ERR_STACK(s);
 }
 
@@ -1890,6 +2272,10 @@ natsLib_msgDeliveryAssignWorker(natsSubscription *sub)
     natsStatus          s = NATS_OK;
     natsLibDlvWorkers   *workers = &(gLib.dlvWorkers);
     natsMsgDlvWorker    *worker = NULL;
+    int                 best = -1;
+    int                 bestLoad = 0;
+    int                 bestSubs = 0;
+    int                 i;
 
     natsMutex_Lock(workers->lock);
 
@@ -1899,38 +2285,38 @@ natsLib_msgDeliveryAssignWorker(natsSubscription *sub)
         return nats_setError(NATS_FAILED_TO_INITIALIZE, "%s", "Message delivery thread pool size is 0!");
     }
 
-    worker = workers->workers[workers->idx];
-    if (worker == NULL)
+    // Pick the active worker with the least work queued, then with the
+    // fewest subscriptions. A worker not yet created has neither.
+    for (i=0; i<workers->maxSize; i++)
     {
-        worker = NATS_CALLOC(1, sizeof(natsMsgDlvWorker));
-        if (worker == NULL)
-            s = nats_setDefaultError(NATS_NO_MEMORY);
-        if (s == NATS_OK)
-            s = natsMutex_Create(&worker->lock);
-        if (s == NATS_OK)
-            s = natsCondition_Create(&worker->cond);
-        if (s == NATS_OK)
-        {
-            natsLib_Retain();
-            s = natsThread_Create(&worker->thread, _deliverMsgs, (void*) worker);
-            if (s != NATS_OK)
-                natsLib_Release();
-        }
-        if (s == NATS_OK)
+        natsMsgDlvWorker    *w    = workers->workers[i];
+        int                 load  = 0;
+        int                 nsubs = 0;
+
+        if (w != NULL)
         {
-            workers->workers[workers->idx] = worker;
-            workers->size++;
+            load  = _dlvWorkerLoad(w);
+            nsubs = nats_atomicGet(&(w->numSubs));
         }
-        else
+        if ((best < 0)
+            || (load < bestLoad)
+            || ((load == bestLoad) && (nsubs < bestSubs)))
         {
-            _freeDlvWorker(worker);
+            best     = i;
+            bestLoad = load;
+            bestSubs = nsubs;
         }
     }
+
+    worker = workers->workers[best];
+    if (worker == NULL)
+        s = _createDlvWorker(&worker, best);
+
     if (s == NATS_OK)
     {
         sub->libDlvWorker = worker;
-        if (++(workers->idx) == workers->maxSize)
-            workers->idx = 0;
+        sub->dlvHome      = worker;
+        nats_atomicInc(&(worker->numSubs));
     }
 
     natsMutex_Unlock(workers->lock);
@@ -1938,6 +2324,98 @@ natsLib_msgDeliveryAssignWorker(natsSubscription *sub)
     return NATS_UPDATE_ERR_STACK(s);
 }
 
+natsStatus
+nats_SetTimerPoolSize(int size)
+{
+    natsStatus          s = NATS_OK;
+    natsLibTimerThreads *pool;
+
+    if ((size <= 0) || (size > NATS_LIB_MAX_TIMER_THREADS))
+        return nats_setError(NATS_INVALID_ARG,
+                             "Timer pool size must be between 1 and %d",
+                             NATS_LIB_MAX_TIMER_THREADS);
+
+    // Ensure the library is loaded
+    s = nats_Open(-1);
+    if (s != NATS_OK)
+        return s;
+
+    pool = &gLib.timers;
+
+    // The library's lock is held so that the threads are not created
+    // after the library has been closed.
+    natsMutex_Lock(gLib.lock);
+
+    if (gLib.closed)
+    {
+        natsMutex_Unlock(gLib.lock);
+        return nats_setDefaultError(NATS_ILLEGAL_STATE);
+    }
+
+    natsMutex_Lock(pool->lock);
+
+    while ((s == NATS_OK) && (pool->size < size))
+        s = _createTimerThread();
+
+    if (s == NATS_OK)
+    {
+        pool->maxSize = size;
+        if (pool->next >= size)
+            pool->next = 0;
+    }
+
+    natsMutex_Unlock(pool->lock);
+    natsMutex_Unlock(gLib.lock);
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
+natsStatus
+nats_GetMessageDeliveryPoolStats(natsDeliveryWorkerStats *stats, int maxStats, int *count)
+{
+    natsStatus          s = NATS_OK;
+    natsLibDlvWorkers   *workers;
+    int                 i;
+
+    if ((count == NULL) || (maxStats < 0) || ((stats == NULL) && (maxStats > 0)))
+        return nats_setDefaultError(NATS_INVALID_ARG);
+
+    // Ensure the library is loaded
+    s = nats_Open(-1);
+    if (s != NATS_OK)
+        return s;
+
+    workers = &gLib.dlvWorkers;
+
+    natsMutex_Lock(workers->lock);
+
+    for (i=0; (i<workers->size) && (i<maxStats); i++)
+    {
+        natsMsgDlvWorker        *w   = workers->workers[i];
+        natsDeliveryWorkerStats *ws  = &(stats[i]);
+        natsSubscription        *sub = NULL;
+
+        memset(ws, 0, sizeof(natsDeliveryWorkerStats));
+
+        ws->subscriptions = nats_atomicGet(&(w->numSubs));
+        ws->active        = (i < workers->maxSize);
+
+        natsMutex_Lock(w->runLock);
+        ws->queuedSubscriptions = w->runLen;
+        for (sub = w->runHead; sub != NULL; sub = sub->dlvNext)
+            ws->pendingMsgs += nats_atomicGet(&(sub->pendingMsgs));
+        ws->busyTime            = w->busyTime;
+        ws->deliveredMsgs       = w->delivered;
+        ws->stolenSubscriptions = w->steals;
+        natsMutex_Unlock(w->runLock);
+    }
+    *count = workers->size;
+
+    natsMutex_Unlock(workers->lock);
+
+    return NATS_OK;
+}
+
 bool
 natsLib_isLibHandlingMsgDeliveryByDefault()
 {
@@ -1951,14 +2429,13 @@ natsLib_defaultWriteDeadline()
 }
 
 void
-natsLib_getMsgDeliveryPoolInfo(int *maxSize, int *size, int *idx, natsMsgDlvWorker ***workersArray)
+natsLib_getMsgDeliveryPoolInfo(int *maxSize, int *size, natsMsgDlvWorker ***workersArray)
 {
     natsLibDlvWorkers *workers = &gLib.dlvWorkers;
 
     natsMutex_Lock(workers->lock);
     *maxSize = workers->maxSize;
     *size = workers->size;
-    *idx = workers->idx;
     *workersArray = workers->workers;
     natsMutex_Unlock(workers->lock);
 }
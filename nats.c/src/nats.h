@@ -45,9 +45,22 @@ extern "C" {
   #endif
 
   typedef SOCKET      natsSock;
+
+  // Windows does not have `struct iovec`, so use a library owned structure
+  // with the same fields.
+  typedef struct __natsIOVec
+  {
+      void    *iov_base;
+      size_t  iov_len;
+
+  } natsIOVec;
 #else
+  #include <sys/uio.h>
+
   #define NATS_EXTERN
   typedef int         natsSock;
+
+  typedef struct iovec natsIOVec;
 #endif
 
 /*! \mainpage %NATS C client.
@@ -127,6 +140,22 @@ typedef struct __natsMsg            natsMsg;
  */
 typedef struct __natsOptions        natsOptions;
 
+/** \brief A publisher bound to a subject.
+ *
+ * A #natsPublisher pre-encodes the protocol for a given subject (and
+ * optional reply subject), which makes sending many messages to a fixed
+ * subject cheaper than with #natsConnection_Publish().
+ */
+typedef struct __natsPublisher      natsPublisher;
+
+/** \brief Dispatches messages to local handlers based on their subject.
+ *
+ * A #natsRouter owns a single (usually wildcard) subscription and invokes
+ * the handlers whose subject matches the subject of each message, so that
+ * many related subjects can be handled without a subscription for each.
+ */
+typedef struct __natsRouter         natsRouter;
+
 /** \brief Unique subject often used for point-to-point communication.
  *
  * This can be used as the reply for a request. Inboxes are meant to be
@@ -136,6 +165,76 @@ typedef struct __natsOptions        natsOptions;
  */
 typedef char                        natsInbox;
 
+/** \brief A message to be sent with #natsConnection_PublishBatch().
+ *
+ * Each item describes a single message: the subject, an optional reply
+ * subject and the payload. Items of a batch are sent in array order.
+ */
+typedef struct __natsPubItem
+{
+    const char  *subject;   ///< The subject the data is sent to.
+    const char  *reply;     ///< The optional reply subject, can be `NULL`.
+    const void  *data;      ///< The data to be sent, can be `NULL`.
+    int         dataLen;    ///< The length of the data to be sent.
+
+} natsPubItem;
+
+/** \brief Statistics of a worker of the global message delivery thread pool.
+ *
+ * See #nats_GetMessageDeliveryPoolStats() for details.
+ */
+typedef struct __natsDeliveryWorkerStats
+{
+    int         subscriptions;          ///< Number of subscriptions for which this worker currently delivers messages.
+    int         queuedSubscriptions;    ///< Number of subscriptions waiting in this worker's queue.
+    int         pendingMsgs;            ///< Number of pending messages of the subscriptions waiting in this worker's queue.
+    int64_t     busyTime;               ///< Time (in nanoseconds) this worker has spent delivering messages.
+    uint64_t    deliveredMsgs;          ///< Number of messages (including internal ones) this worker has delivered.
+    uint64_t    stolenSubscriptions;    ///< Number of times this worker has taken a subscription from another worker's queue.
+    bool        active;                 ///< `false` if the worker is parked after the pool has been shrunk.
+
+} natsDeliveryWorkerStats;
+
+/** \brief Ordering of messages delivered by a parallel subscription.
+ *
+ * See #natsConnection_SubscribeParallel() for details.
+ */
+typedef enum
+{
+    NATS_PARALLEL_UNORDERED = 0,    ///< Messages are delivered by whichever thread is available,
+                                    ///  in no particular order.
+    NATS_PARALLEL_ORDER_BY_SUBJECT, ///< Messages with the same subject are delivered in order,
+                                    ///  by the same thread.
+    NATS_PARALLEL_ORDER_BY_KEY,     ///< Messages with the same key, as returned by the
+                                    ///  #natsMsgKeyHandler, are delivered in order, by the same thread.
+
+} natsParallelOrder;
+
+/** \brief Policies used by the flusher to decide when to send buffered data.
+ *
+ * See #natsOptions_SetFlushPolicy() for details.
+ */
+typedef enum
+{
+    NATS_FLUSH_POLICY_FIXED = 0,    ///< Waits a fixed amount of time after new data has been
+                                    ///  buffered, or less if enough bytes have been buffered.
+    NATS_FLUSH_POLICY_ADAPTIVE,     ///< Flushes right away when the connection is idle, and
+                                    ///  coalesces writes based on the recent publish rate.
+
+} natsFlushPolicy;
+
+/** \brief What to do when publishing would exceed the outbound limit.
+ *
+ * See #natsOptions_SetMaxOutboundBytes() for details.
+ */
+typedef enum
+{
+    NATS_OUTBOUND_POLICY_BLOCK = 0, ///< The publish call blocks until there is enough room.
+    NATS_OUTBOUND_POLICY_FAIL,      ///< The publish call fails with #NATS_OUTBOUND_LIMIT_REACHED.
+    NATS_OUTBOUND_POLICY_DROP,      ///< The message is silently dropped.
+
+} natsOutboundPolicy;
+
 #if defined(NATS_HAS_STREAMING)
 /** \brief A connection to a `NATS Streaming Server`.
  *
@@ -192,6 +291,57 @@ typedef struct __stanSubOptions     stanSubOptions;
 typedef void (*natsMsgHandler)(
         natsConnection *nc, natsSubscription *sub, natsMsg *msg, void *closure);
 
+/** \brief Callback used to deliver batches of messages to the application.
+ *
+ * This is the callback that one provides when creating a batch subscription.
+ * The library invokes this callback with up to the subscription's maximum
+ * batch size of messages, in the order they were received.
+ *
+ * The user is responsible for destroying each message, but the `msgs` array
+ * itself belongs to the library and is only valid until the callback returns.
+ *
+ * \note If the subscription was created with a timeout, the callback is
+ * invoked with `msgs` set to `NULL` and `count` to `0` when the subscription
+ * times out.
+ *
+ * @see natsConnection_SubscribeBatch()
+ * @see natsConnection_SubscribeBatchTimeout()
+ */
+typedef void (*natsMsgBatchHandler)(
+        natsConnection *nc, natsSubscription *sub, natsMsg **msgs, int count,
+        void *closure);
+
+/** \brief Callback used to get the ordering key of a message.
+ *
+ * This is the callback that one provides when creating a parallel
+ * subscription ordered by key (see #NATS_PARALLEL_ORDER_BY_KEY). Messages
+ * for which the same key is returned are delivered in the order they were
+ * received. The key can be for instance a hash of a header or of a field
+ * of the payload.
+ *
+ * \warning This callback is invoked from the connection's thread reading
+ * from the socket. It must be fast, must not block and must not destroy
+ * the message.
+ *
+ * @see natsConnection_SubscribeParallel()
+ */
+typedef uint64_t (*natsMsgKeyHandler)(
+        natsMsg *msg, void *closure);
+
+/** \brief Callback used by a #natsRouter to deliver messages.
+ *
+ * This is the callback that one provides when adding a handler to a router.
+ * It is invoked for each message whose subject matches the handler's subject.
+ *
+ * \note Unlike with #natsMsgHandler, the message belongs to the router: it
+ * may be passed to several handlers and is destroyed once they have all been
+ * invoked. The handler must not destroy it, nor use it after returning.
+ *
+ * @see natsRouter_AddHandler()
+ */
+typedef void (*natsRouteHandler)(
+        natsConnection *nc, natsRouter *router, natsMsg *msg, void *closure);
+
 /** \brief Callback used to notify the user of asynchronous connection events.
  *
  * This callback is used for asynchronous events such as disconnected
@@ -542,14 +692,18 @@ nats_PrintLastErrorStack(FILE *file);
  * lazily initialized, that is, no thread is used as long as no subscriber
  * (requiring global message delivery) is created.
  *
- * Each subscriber will be attached to a given worker on the pool so that
- * message delivery order is guaranteed.
+ * Subscribers are attached to the least busy worker of the pool. The
+ * messages of a given subscriber are delivered by a single worker at a
+ * time, so that message delivery order is guaranteed, but a subscriber
+ * that has messages waiting behind a busy worker may be moved to, or taken
+ * by, a worker that has nothing to do.
  *
  * This call allows you to set the maximum size of the pool.
  *
- * \note At this time, a pool does not shrink, but the caller will not get
- * an error when calling this function with a size smaller than the current
- * size.
+ * \note If the size is smaller than the number of threads already started,
+ * the threads past this size are not stopped, but they no longer get new
+ * subscribers and their current subscribers move to the other threads the
+ * next time they have messages to deliver.
  *
  * @see natsOptions_UseGlobalMessageDelivery()
  * @see \ref envVariablesGroup
@@ -559,6 +713,42 @@ nats_PrintLastErrorStack(FILE *file);
 NATS_EXTERN natsStatus
 nats_SetMessageDeliveryPoolSize(int max);
 
+/** \brief Returns statistics of the global message delivery thread pool.
+ *
+ * Fills the `stats` array with the statistics of the threads of the pool
+ * that have been started, up to `maxStats` entries, and sets `count` to the
+ * number of threads started so far.
+ *
+ * This can be used to see how the load is spread across the pool, for
+ * instance to decide of its size (see #nats_SetMessageDeliveryPoolSize()).
+ *
+ * @param stats the array of #natsDeliveryWorkerStats to fill, can be `NULL`
+ * if `maxStats` is `0`.
+ * @param maxStats the number of elements in the `stats` array.
+ * @param count the location where to store the number of threads of the pool.
+ */
+NATS_EXTERN natsStatus
+nats_GetMessageDeliveryPoolStats(natsDeliveryWorkerStats *stats, int maxStats, int *count);
+
+/** \brief Sets the number of threads firing the library's timers.
+ *
+ * The library uses timers for things such as pings, reconnect attempts,
+ * subscription timeouts or drain deadlines. They are fired by a single
+ * thread by default, which may delay timers when there are many
+ * connections or subscriptions, or when some timer callbacks are slow.
+ *
+ * This call allows you to have timers spread over more threads. Timers
+ * are assigned to a thread when created and stay on that thread.
+ *
+ * \note If the size is smaller than the number of threads already started,
+ * the threads past this size are not stopped, but no new timer is assigned
+ * to them.
+ *
+ * @param size the number of timer threads, between 1 and 64.
+ */
+NATS_EXTERN natsStatus
+nats_SetTimerPoolSize(int size);
+
 /** \brief Release thread-local memory possibly allocated by the library.
  *
  * This needs to be called on user-created threads where NATS calls are
@@ -707,6 +897,49 @@ natsStatistics_GetCounts(natsStatistics *stats,
                          uint64_t *outMsgs, uint64_t *outBytes,
                          uint64_t *reconnects);
 
+/** \brief Extracts the flush statistics.
+ *
+ * Gets the number of times the outbound buffer has been written to the
+ * socket, and the average number of bytes written each time.
+ *
+ * \note You can pass `NULL` to any of the count your are not interested in
+ * getting.
+ *
+ * @see natsConnection_GetStats()
+ * @see natsOptions_SetFlushPolicy()
+ *
+ * @param stats the pointer to the #natsStatistics object to get the values from.
+ * @param flushes total number of writes of the outbound buffer.
+ * @param avgBytesPerFlush average size (in bytes) of those writes.
+ */
+NATS_EXTERN natsStatus
+natsStatistics_GetFlushCounts(natsStatistics *stats,
+                              uint64_t *flushes, uint64_t *avgBytesPerFlush);
+
+/** \brief Extracts the message pool statistics.
+ *
+ * Gets the number of received messages whose memory was taken from the
+ * connection's message pool (hits), and the number of received messages
+ * for which memory had to be allocated (misses), either because no free
+ * message of the right size was available, or because the message was
+ * too big to be pooled.
+ *
+ * Both counts are `0` if the message pool is not enabled.
+ *
+ * \note You can pass `NULL` to any of the count your are not interested in
+ * getting.
+ *
+ * @see natsConnection_GetStats()
+ * @see natsOptions_SetMsgPool()
+ *
+ * @param stats the pointer to the #natsStatistics object to get the values from.
+ * @param hits number of messages allocated from the pool.
+ * @param misses number of messages that could not be allocated from the pool.
+ */
+NATS_EXTERN natsStatus
+natsStatistics_GetMsgPoolCounts(natsStatistics *stats,
+                                uint64_t *hits, uint64_t *misses);
+
 /** \brief Destroys the #natsStatistics object.
  *
  * Destroys the statistics object, freeing up memory.
@@ -1375,6 +1608,251 @@ natsOptions_IPResolutionOrder(natsOptions *opts, int order);
 NATS_EXTERN natsStatus
 natsOptions_SetSendAsap(natsOptions *opts, bool sendAsap);
 
+/** \brief Reduces lock contention when many threads publish on the same connection.
+ *
+ * By default, each publish call acquires the connection's lock to
+ * add the message to the outbound buffer. When many threads publish
+ * on the same connection, they end-up contending on this lock.
+ *
+ * Setting this option to `true` will make publish calls append the
+ * message to a staging area selected by the calling thread, without
+ * acquiring the connection's lock. The flusher thread moves the content
+ * of those staging areas to the outbound buffer before sending it
+ * to the server.
+ *
+ * Messages published by a given thread are still sent in the order
+ * they were published, and a call to #natsConnection_Flush (or any
+ * of its variants) ensures that all messages published by the calling
+ * thread prior to this call have been processed by the server. There
+ * is no ordering guarantee between messages published by different threads.
+ *
+ * \note Messages that sit in a staging area are not yet accounted for
+ * in the connection's statistics (see #natsConnection_GetStats).
+ *
+ * \note This option has no effect if #natsOptions_SetSendAsap is
+ * set to `true`, or if #natsOptions_SetMaxOutboundBytes is used.
+ *
+ * @param opts the pointer to the #natsOptions object.
+ * @param concurrent a boolean indicating if publish calls should use
+ * per-thread staging areas.
+ */
+NATS_EXTERN natsStatus
+natsOptions_SetConcurrentPublish(natsOptions *opts, bool concurrent);
+
+/** \brief Sets the policy used to decide when buffered data is sent.
+ *
+ * Unless #natsOptions_SetSendAsap() is used, published data is accumulated
+ * in a buffer and the flusher thread is notified. This option controls
+ * how long the flusher waits for more data before sending the buffer.
+ *
+ * With #NATS_FLUSH_POLICY_FIXED, the flusher waits `maxDelay` milliseconds,
+ * unless the buffer holds at least `minBytes` bytes (if `minBytes` is
+ * positive). A `maxDelay` of `0` means that the buffer is sent as soon
+ * as the flusher is notified.
+ *
+ * With #NATS_FLUSH_POLICY_ADAPTIVE, the flusher tracks the recent publish
+ * rate. If the connection was idle, or if a single message was published
+ * since the last flush (as with request/reply traffic), the buffer is sent
+ * right away, which minimizes the latency of a lone message. Under load, the flusher waits
+ * for the time it estimates is needed to accumulate `minBytes` bytes
+ * (the size of the buffer if `minBytes` is `0`), but never more than
+ * `maxDelay` milliseconds.
+ *
+ * The default is #NATS_FLUSH_POLICY_FIXED with a `maxDelay` of 1
+ * millisecond and no byte threshold.
+ *
+ * \note The number of flushes and average bytes per flush can be retrieved
+ * with #natsStatistics_GetFlushCounts() to help tune those values.
+ *
+ * @param opts the pointer to the #natsOptions object.
+ * @param policy the #natsFlushPolicy to use.
+ * @param maxDelay the maximum time, in milliseconds, the flusher waits
+ * before sending the buffer.
+ * @param minBytes the number of buffered bytes that causes the buffer to be
+ * sent without waiting further.
+ */
+NATS_EXTERN natsStatus
+natsOptions_SetFlushPolicy(natsOptions *opts, natsFlushPolicy policy,
+                           int64_t maxDelay, int minBytes);
+
+/** \brief Limits the number of bytes buffered for sending.
+ *
+ * When the network is slow, or while the library is reconnecting, published
+ * data accumulates in the connection's buffers (see #natsConnection_Buffered()).
+ * This option limits how much data can be buffered. When a publish call would
+ * cause the limit to be exceeded, the `policy` decides what happens:
+ *
+ * - #NATS_OUTBOUND_POLICY_BLOCK: the call blocks until the flusher has sent
+ * enough data, or the connection is reconnected or closed.
+ * - #NATS_OUTBOUND_POLICY_FAIL: the call returns #NATS_OUTBOUND_LIMIT_REACHED.
+ * - #NATS_OUTBOUND_POLICY_DROP: the message is silently discarded.
+ *
+ * A message is always accepted if nothing is buffered, even if it is larger
+ * than the limit.
+ *
+ * \note Since the reconnect buffer is limited by #natsOptions_SetReconnectBufSize(),
+ * a publish call may still fail with #NATS_INSUFFICIENT_BUFFER while reconnecting.
+ *
+ * \note When this option is set, #natsOptions_SetConcurrentPublish() has
+ * no effect.
+ *
+ * @param opts the pointer to the #natsOptions object.
+ * @param maxBytes the maximum number of bytes buffered for sending, `0` meaning
+ * no limit.
+ * @param policy the #natsOutboundPolicy to apply when the limit is reached.
+ */
+NATS_EXTERN natsStatus
+natsOptions_SetMaxOutboundBytes(natsOptions *opts, int64_t maxBytes,
+                                natsOutboundPolicy policy);
+
+/** \brief Sets the callback to be invoked when outbound data reaches a high watermark.
+ *
+ * Specifies the callback to invoke when the number of bytes buffered for sending
+ * reaches `bytes`. The callback will not be invoked again until the number of
+ * buffered bytes goes back down to the low watermark (see
+ * #natsOptions_SetOutboundLowWatermarkCB()). This allows producers to throttle
+ * themselves before publish calls start to block or fail.
+ *
+ * \warning Invocation of this callback is asynchronous, which means that
+ * the number of buffered bytes may have changed when this callback is invoked.
+ *
+ * @param opts the pointer to the #natsOptions object.
+ * @param bytes the high watermark, `0` to disable.
+ * @param highCb the callback to be invoked when the high watermark is reached.
+ * @param closure a pointer to an user object that will be passed to
+ * the callback. `closure` can be `NULL`.
+ */
+NATS_EXTERN natsStatus
+natsOptions_SetOutboundHighWatermarkCB(natsOptions *opts, int64_t bytes,
+                                       natsConnectionHandler highCb,
+                                       void *closure);
+
+/** \brief Sets the callback to be invoked when outbound data goes back to a low watermark.
+ *
+ * Specifies the callback to invoke when, after the high watermark has been
+ * reached, the number of bytes buffered for sending goes down to `bytes`
+ * or less.
+ *
+ * \warning Invocation of this callback is asynchronous, which means that
+ * the number of buffered bytes may have changed when this callback is invoked.
+ *
+ * @param opts the pointer to the #natsOptions object.
+ * @param bytes the low watermark.
+ * @param lowCb the callback to be invoked when the low watermark is reached.
+ * @param closure a pointer to an user object that will be passed to
+ * the callback. `closure` can be `NULL`.
+ */
+NATS_EXTERN natsStatus
+natsOptions_SetOutboundLowWatermarkCB(natsOptions *opts, int64_t bytes,
+                                      natsConnectionHandler lowCb,
+                                      void *closure);
+
+/** \brief Avoids copying the content of received messages.
+ *
+ * By default, the subject, reply and payload of each received message
+ * are copied from the connection's read buffer into memory allocated
+ * for the message.
+ *
+ * Setting this option to `true` makes the library read from the socket
+ * into reference counted memory blocks. Messages that are fully contained
+ * in a single read point directly into those blocks, and each holds a
+ * reference that is released when the message is destroyed. Messages
+ * that are split across reads are still copied. This does not change the
+ * behavior of the `natsMsg_Get*` accessors.
+ *
+ * \note A block of #natsOptions_SetIOBufSize() bytes is kept in memory
+ * as long as at least one message pointing into it has not been destroyed.
+ * Applications that keep many messages around for a long time should
+ * not use this option.
+ *
+ * \note This option has no effect when an external event loop is used
+ * (see #natsOptions_SetEventLoop()).
+ *
+ * @param opts the pointer to the #natsOptions object.
+ * @param zeroCopy a boolean indicating if received messages should point
+ * into the read buffers instead of being copied.
+ */
+NATS_EXTERN natsStatus
+natsOptions_SetZeroCopyReceive(natsOptions *opts, bool zeroCopy);
+
+/** \brief Recycles the memory of received messages.
+ *
+ * By default, memory is allocated for each received message, and freed
+ * when the message is destroyed.
+ *
+ * When `enabled` is `true`, destroyed messages are instead returned to a
+ * pool owned by the connection, and reused for subsequent messages. The
+ * pool uses size classes of 128, 512, 2048 and 8192 bytes (this includes
+ * the subject, reply and payload, and some overhead). Larger messages are
+ * not pooled. Messages are returned to one of several lists selected by
+ * the thread destroying them, which limits contention when messages are
+ * destroyed from many threads.
+ *
+ * The number of messages taken from the pool can be retrieved with
+ * #natsStatistics_GetMsgPoolCounts().
+ *
+ * \note The memory of the pool is released once the connection is destroyed
+ * and all messages allocated from it have been destroyed.
+ *
+ * @param opts the pointer to the #natsOptions object.
+ * @param enabled a boolean indicating if received messages should use the pool.
+ * @param maxFree the maximum number of free messages kept per size class,
+ * `0` to use the default of `1024`.
+ */
+NATS_EXTERN natsStatus
+natsOptions_SetMsgPool(natsOptions *opts, bool enabled, int maxFree);
+
+/** \brief Frees received messages in the thread that destroys them.
+ *
+ * By default, #natsMsg_Destroy() hands the message over to the library's
+ * garbage collector thread, which frees it. This keeps the cost of freeing
+ * the memory out of the message callbacks, but all messages of the process
+ * go through that single thread.
+ *
+ * Setting this option to `true` makes #natsMsg_Destroy() free the messages
+ * received on this connection directly in the calling thread. This is
+ * recommended when many threads process messages in parallel, in particular
+ * when used with #natsOptions_SetMsgPool(), since destroyed messages are then
+ * immediately available for reuse.
+ *
+ * @param opts the pointer to the #natsOptions object.
+ * @param inlineFree a boolean indicating if received messages should be freed
+ * by the thread destroying them.
+ */
+NATS_EXTERN natsStatus
+natsOptions_SetInlineMsgFree(natsOptions *opts, bool inlineFree);
+
+/** \brief Trades CPU for latency by busy polling instead of waiting.
+ *
+ * By default, the thread reading from the socket waits for the socket to
+ * be readable when there is no data, and the threads delivering messages
+ * (or calling #natsSubscription_NextMsg) wait to be signaled when there is
+ * no message. Each wake up then goes through the scheduler.
+ *
+ * If `spin` is greater than 0, those threads instead keep checking, for up
+ * to `spin` microseconds, for data on the socket or messages in the
+ * subscription's queue, before waiting. This is intended for deployments
+ * with dedicated cores, since the threads use a full core while they spin.
+ *
+ * If `sockBusyPoll` is greater than 0, the socket's `SO_BUSY_POLL` option
+ * is set to this value (in microseconds), which makes the kernel poll the
+ * network device when the socket has no data. This is only supported on
+ * Linux, and values above the `net.core.busy_read` setting may require the
+ * `CAP_NET_ADMIN` capability, in which case connecting fails.
+ *
+ * \note Threads of the library's delivery pool (see
+ * #natsOptions_UseGlobalMessageDelivery) are shared by connections and do
+ * not use this option.
+ *
+ * @param opts the pointer to the #natsOptions object.
+ * @param spin the time (in microseconds) to spin before waiting, 0 to
+ * disable.
+ * @param sockBusyPoll the value (in microseconds) of the `SO_BUSY_POLL`
+ * socket option, 0 to leave it unset.
+ */
+NATS_EXTERN natsStatus
+natsOptions_SetBusyPoll(natsOptions *opts, int64_t spin, int sockBusyPoll);
+
 /** \brief Switches the use of old style requests.
  *
  * Setting `useOldStyle` to `true` forces the request calls to use the original
@@ -2278,6 +2756,10 @@ natsConnection_Status(natsConnection *nc);
  * for better performance. This function indicates if there is any
  * data not yet transmitted to the server.
  *
+ * While the library is reconnecting, this includes the data accumulated
+ * in the reconnect buffer (see #natsOptions_SetReconnectBufSize), which
+ * decreases as it is sent to the server after the reconnect.
+ *
  * @param nc the pointer to the #natsConnection object.
  * @return the number of bytes to be sent to the server, or -1 if the
  * connection is closed.
@@ -2612,6 +3094,60 @@ NATS_EXTERN natsStatus
 natsConnection_PublishRequestString(natsConnection *nc, const char *subj,
                                     const char *reply, const char *str);
 
+/** \brief Publishes data, provided as a list of segments, on a subject.
+ *
+ * Publishes a single message whose payload is the concatenation of the
+ * `iovcnt` segments described by `iov`. This allows sending, for instance,
+ * an application header and a body without having to concatenate them
+ * in a new buffer first.
+ *
+ * Segments that do not fit in the connection's outbound buffer are not
+ * copied, but are written to the socket directly from the user memory
+ * (using a gather write when possible).
+ *
+ * @param nc the pointer to the #natsConnection object.
+ * @param subj the subject the data is sent to.
+ * @param reply the optional reply subject, can be `NULL`.
+ * @param iov the array of segments making up the data, can be `NULL` if
+ * `iovcnt` is `0`. On platforms that have it, #natsIOVec is `struct iovec`.
+ * @param iovcnt the number of segments in the array.
+ */
+NATS_EXTERN natsStatus
+natsConnection_PublishV(natsConnection *nc, const char *subj,
+                        const char *reply, const natsIOVec *iov,
+                        int iovcnt);
+
+/** \brief Publishes a batch of messages.
+ *
+ * Publishes all items of the given array, in order. This is equivalent to
+ * calling #natsConnection_PublishRequest() (or #natsConnection_Publish() if
+ * an item has no reply subject) for each item, but the connection lock is
+ * acquired only once, and the flusher is kicked (or the buffer flushed when
+ * #natsOptions_SetSendAsap() is used) only once, at the end of the batch.
+ *
+ * All subjects are validated before anything is sent. If one is invalid,
+ * this call returns #NATS_INVALID_SUBJECT and no message is published.
+ *
+ * An item whose payload exceeds the server's maximum payload is skipped and
+ * the other items are still sent. If the library is reconnecting and the
+ * reconnect buffer (see #natsOptions_SetReconnectBufSize()) becomes full,
+ * this item and all remaining ones are not sent.
+ *
+ * If `itemsStatus` is not `NULL`, it must be an array of at least `count`
+ * elements. On return, each element holds the status of the corresponding
+ * item: #NATS_OK if it was sent, or the reason why it was not.
+ *
+ * @param nc the pointer to the #natsConnection object.
+ * @param items the array of #natsPubItem to send.
+ * @param count the number of items in the array.
+ * @param itemsStatus the optional array where to store the status of each item.
+ * @return #NATS_OK if all items have been sent, or the status of the first
+ * item that failed.
+ */
+NATS_EXTERN natsStatus
+natsConnection_PublishBatch(natsConnection *nc, const natsPubItem *items,
+                            int count, natsStatus *itemsStatus);
+
 /** \brief Sends a request and waits for a reply.
  *
  * Sends a request payload and delivers the first response message,
@@ -2717,6 +3253,152 @@ natsConnection_SubscribeTimeout(natsSubscription **sub, natsConnection *nc,
                                 const char *subject, int64_t timeout,
                                 natsMsgHandler cb, void *cbClosure);
 
+/** \brief Creates an asynchronous subscription that delivers messages in batches.
+ *
+ * Expresses interest in the given subject. The subject can have wildcards
+ * (see \ref wildcardsGroup). Messages will be delivered to the associated
+ * #natsMsgBatchHandler, up to `maxBatch` messages at a time.
+ *
+ * Once a message is available, the delivery thread waits up to `linger`
+ * milliseconds for more messages before invoking the callback, unless
+ * `maxBatch` messages are available sooner. If `linger` is `0`, the callback
+ * is invoked with the messages already pending, without waiting.
+ *
+ * Auto-unsubscribe (see #natsSubscription_AutoUnsubscribe) and drain
+ * (see #natsSubscription_Drain) work as for regular asynchronous
+ * subscriptions: no more than the given maximum of messages are delivered,
+ * and a batch never contains messages past that maximum.
+ *
+ * \note Batch subscriptions always use their own delivery thread, even if
+ * the connection is configured to use the library's delivery pool (see
+ * #natsOptions_UseGlobalMessageDelivery).
+ *
+ * @param sub the location where to store the pointer to the newly created
+ * #natsSubscription object.
+ * @param nc the pointer to the #natsConnection object.
+ * @param subject the subject this subscription is created for.
+ * @param maxBatch the maximum number of messages passed to the callback at once.
+ * @param linger the maximum time (in milliseconds) to wait for more messages
+ * once a message is available.
+ * @param cb the #natsMsgBatchHandler callback.
+ * @param cbClosure a pointer to an user defined object (can be `NULL`). See
+ * the #natsMsgBatchHandler prototype.
+ */
+NATS_EXTERN natsStatus
+natsConnection_SubscribeBatch(natsSubscription **sub, natsConnection *nc,
+                              const char *subject, int maxBatch, int64_t linger,
+                              natsMsgBatchHandler cb, void *cbClosure);
+
+/** \brief Creates an asynchronous subscription that delivers messages in batches, with a timeout.
+ *
+ * Similar to #natsConnection_SubscribeBatch(), except that if no message
+ * is received by the given timeout (in milliseconds), the callback is
+ * invoked with a `NULL` array and a count of `0`.
+ *
+ * @see natsConnection_SubscribeBatch()
+ *
+ * @param sub the location where to store the pointer to the newly created
+ * #natsSubscription object.
+ * @param nc the pointer to the #natsConnection object.
+ * @param subject the subject this subscription is created for.
+ * @param maxBatch the maximum number of messages passed to the callback at once.
+ * @param linger the maximum time (in milliseconds) to wait for more messages
+ * once a message is available.
+ * @param timeout the interval (in milliseconds) after which, if no message
+ * is received, the callback is invoked with no message.
+ * @param cb the #natsMsgBatchHandler callback.
+ * @param cbClosure a pointer to an user defined object (can be `NULL`). See
+ * the #natsMsgBatchHandler prototype.
+ */
+NATS_EXTERN natsStatus
+natsConnection_SubscribeBatchTimeout(natsSubscription **sub, natsConnection *nc,
+                                     const char *subject, int maxBatch, int64_t linger,
+                                     int64_t timeout, natsMsgBatchHandler cb,
+                                     void *cbClosure);
+
+/** \brief Creates an asynchronous subscription whose callback is invoked by several threads.
+ *
+ * Expresses interest in the given subject. The subject can have wildcards
+ * (see \ref wildcardsGroup). Messages will be delivered to the associated
+ * #natsMsgHandler by `lanes` delivery threads, so that a callback doing
+ * expensive processing can use several cores.
+ *
+ * With #NATS_PARALLEL_UNORDERED, a message is delivered by the first
+ * available thread, so messages may be processed in any order, and
+ * concurrently. Otherwise, messages are assigned to a thread based on their
+ * subject (#NATS_PARALLEL_ORDER_BY_SUBJECT) or on the key returned by
+ * `keyCb` (#NATS_PARALLEL_ORDER_BY_KEY). Messages with the same subject,
+ * or key, are then delivered in the order they were received.
+ *
+ * Auto-unsubscribe (see #natsSubscription_AutoUnsubscribe) and drain
+ * (see #natsSubscription_Drain) work as for regular asynchronous
+ * subscriptions: no more than the given maximum of messages are delivered,
+ * and the subscription is drained once all threads are done with the
+ * messages they have. Pending limits (see #natsSubscription_SetPendingLimits)
+ * apply to the subscription as a whole.
+ *
+ * \note Parallel subscriptions always use their own delivery threads, even
+ * if the connection is configured to use the library's delivery pool (see
+ * #natsOptions_UseGlobalMessageDelivery).
+ *
+ * @param sub the location where to store the pointer to the newly created
+ * #natsSubscription object.
+ * @param nc the pointer to the #natsConnection object.
+ * @param subject the subject this subscription is created for.
+ * @param lanes the number of delivery threads.
+ * @param order how messages are ordered (see #natsParallelOrder).
+ * @param keyCb the #natsMsgKeyHandler callback, required with
+ * #NATS_PARALLEL_ORDER_BY_KEY, must be `NULL` otherwise.
+ * @param cb the #natsMsgHandler callback.
+ * @param cbClosure a pointer to an user defined object (can be `NULL`),
+ * passed to both `keyCb` and `cb`.
+ */
+NATS_EXTERN natsStatus
+natsConnection_SubscribeParallel(natsSubscription **sub, natsConnection *nc,
+                                 const char *subject, int lanes,
+                                 natsParallelOrder order, natsMsgKeyHandler keyCb,
+                                 natsMsgHandler cb, void *cbClosure);
+
+/** \brief Creates an asynchronous subscription whose callback is invoked by the reading thread.
+ *
+ * Expresses interest in the given subject. The subject can have wildcards
+ * (see \ref wildcardsGroup). Messages will be delivered to the associated
+ * #natsMsgHandler by the thread that reads them from the socket: the
+ * connection's internal reading thread, or the thread that calls
+ * #natsConnection_ProcessReadEvent when using an external event loop. There
+ * is no handoff to a delivery thread, which reduces latency, but the
+ * connection does not read anything else while the callback runs.
+ *
+ * The callback must therefore not block. In particular, it must not wait for
+ * something that can only be read by this connection. Calls such as
+ * #natsConnection_Flush, #natsConnection_FlushTimeout,
+ * #natsConnection_Request (and variants), #natsSubscription_NextMsg with
+ * a timeout or #natsSubscription_WaitForDrainCompletion, when made from the
+ * callback on the same connection, fail with #NATS_ILLEGAL_STATE instead of
+ * blocking. Publishing, subscribing and unsubscribing are allowed.
+ *
+ * Since messages are not queued, pending limits do not apply and the
+ * subscription can not be a slow consumer. Auto-unsubscribe (see
+ * #natsSubscription_AutoUnsubscribe) and drain (see #natsSubscription_Drain)
+ * work as for regular asynchronous subscriptions, but neither the
+ * subscription nor the connection can be drained from the callback.
+ *
+ * \note Inline subscriptions never use the library's delivery pool (see
+ * #natsOptions_UseGlobalMessageDelivery).
+ *
+ * @param sub the location where to store the pointer to the newly created
+ * #natsSubscription object.
+ * @param nc the pointer to the #natsConnection object.
+ * @param subject the subject this subscription is created for.
+ * @param cb the #natsMsgHandler callback.
+ * @param cbClosure a pointer to an user defined object (can be `NULL`). See
+ * the #natsMsgHandler prototype.
+ */
+NATS_EXTERN natsStatus
+natsConnection_SubscribeInline(natsSubscription **sub, natsConnection *nc,
+                               const char *subject, natsMsgHandler cb,
+                               void *cbClosure);
+
 /** \brief Creates a synchronous subcription.
  *
  * Similar to #natsConnection_Subscribe, but creates a synchronous subscription
@@ -2809,6 +3491,138 @@ natsConnection_QueueSubscribeSync(natsSubscription **sub, natsConnection *nc,
 
 /** @} */ // end of connGroup
 
+/** \defgroup publisherGroup Publisher
+ *
+ *  Publisher functions.
+ *  @{
+ */
+
+/** \brief Creates a publisher for the given subject.
+ *
+ * Creates a #natsPublisher that sends messages on the subject `subj`, with
+ * the optional reply subject `reply`. The protocol header for this subject
+ * is encoded once, here, so that each call to #natsPublisher_Publish() only
+ * needs to add the payload size and the payload itself.
+ *
+ * The publisher retains the connection, but the connection can still be
+ * closed. Publishing then fails with #NATS_CONNECTION_CLOSED.
+ *
+ * \note The publisher can be used from several threads.
+ *
+ * @see natsPublisher_Destroy()
+ *
+ * @param newPub the location where to store the pointer to the newly created
+ * #natsPublisher object.
+ * @param nc the pointer to the #natsConnection object.
+ * @param subj the subject the data will be sent to.
+ * @param reply the optional reply subject, can be `NULL`.
+ */
+NATS_EXTERN natsStatus
+natsPublisher_Create(natsPublisher **newPub, natsConnection *nc,
+                     const char *subj, const char *reply);
+
+/** \brief Publishes data on the publisher's subject.
+ *
+ * This call is equivalent to #natsConnection_Publish() (or
+ * #natsConnection_PublishRequest() if the publisher has a reply subject),
+ * but uses the pre-encoded protocol header.
+ *
+ * @param pub the pointer to the #natsPublisher object.
+ * @param data the data to be sent, can be `NULL`.
+ * @param dataLen the length of the data to be sent.
+ */
+NATS_EXTERN natsStatus
+natsPublisher_Publish(natsPublisher *pub, const void *data, int dataLen);
+
+/** \brief Destroys the publisher.
+ *
+ * Releases memory associated with this publisher.
+ *
+ * @param pub the pointer to the #natsPublisher object to destroy.
+ */
+NATS_EXTERN void
+natsPublisher_Destroy(natsPublisher *pub);
+
+/** @} */ // end of publisherGroup
+
+/** \defgroup routerGroup Router
+ *
+ *  Router functions.
+ *  @{
+ */
+
+/** \brief Creates a router for the given subject.
+ *
+ * Creates a #natsRouter that subscribes to `subject`, which typically
+ * contains wildcards (for instance `prices.>`), and dispatches the messages
+ * it receives to the handlers added with #natsRouter_AddHandler().
+ *
+ * Only this subscription is registered with the server. Handlers are
+ * matched locally, using a subject trie, and the result of the match is
+ * cached per subject.
+ *
+ * The subscription is created like any asynchronous subscription, so it
+ * uses the library's delivery pool if the connection was created with
+ * #natsOptions_UseGlobalMessageDelivery().
+ *
+ * @see natsRouter_Destroy()
+ *
+ * @param newRouter the location where to store the pointer to the newly
+ * created #natsRouter object.
+ * @param nc the pointer to the #natsConnection object.
+ * @param subject the subject (possibly with wildcards) to subscribe to.
+ */
+NATS_EXTERN natsStatus
+natsRouter_Create(natsRouter **newRouter, natsConnection *nc, const char *subject);
+
+/** \brief Adds a handler to the router.
+ *
+ * The callback `cb` will be invoked for each message received by the router
+ * whose subject matches `subject`. The subject can contain the `*` and `>`
+ * wildcards (see \ref wildcardsGroup). When several handlers match a
+ * message, they are all invoked, in no particular order.
+ *
+ * No protocol is sent to the server, so handlers can be added and removed
+ * at any time, including from a handler's callback.
+ *
+ * @param handlerId the location where to store the identifier of the
+ * handler, needed to remove it, can be `NULL`.
+ * @param router the pointer to the #natsRouter object.
+ * @param subject the subject, possibly with wildcards, that messages must
+ * match.
+ * @param cb the #natsRouteHandler callback.
+ * @param closure a pointer to an user defined object (can be `NULL`).
+ */
+NATS_EXTERN natsStatus
+natsRouter_AddHandler(int64_t *handlerId, natsRouter *router,
+                      const char *subject, natsRouteHandler cb, void *closure);
+
+/** \brief Removes a handler from the router.
+ *
+ * Once this call returns, the handler will not be invoked for new messages.
+ * However, if the handler is removed from another thread while a message
+ * is being dispatched, the callback may be running.
+ *
+ * Returns #NATS_NOT_FOUND if there is no handler with this identifier.
+ *
+ * @param router the pointer to the #natsRouter object.
+ * @param handlerId the identifier returned by #natsRouter_AddHandler().
+ */
+NATS_EXTERN natsStatus
+natsRouter_RemoveHandler(natsRouter *router, int64_t handlerId);
+
+/** \brief Destroys the router.
+ *
+ * Unsubscribes the router's subscription. Memory associated with the router
+ * is released once its handlers are no longer invoked.
+ *
+ * @param router the pointer to the #natsRouter object to destroy.
+ */
+NATS_EXTERN void
+natsRouter_Destroy(natsRouter *router);
+
+/** @} */ // end of routerGroup
+
 /** \defgroup subGroup Subscription
  *
  *  NATS Subscriptions.
@@ -2849,6 +3663,30 @@ NATS_EXTERN natsStatus
 natsSubscription_NextMsg(natsMsg **nextMsg, natsSubscription *sub,
                          int64_t timeout);
 
+/** \brief Returns the next available messages.
+ *
+ * Similar to #natsSubscription_NextMsg(), but returns up to `maxMsgs`
+ * messages at once. This call blocks until at least one message is
+ * available (or the timeout expires), and then returns all messages
+ * that are pending in the client, up to `maxMsgs`, without waiting for
+ * more.
+ *
+ * If the subscription has a limit set with #natsSubscription_AutoUnsubscribe,
+ * no message past this limit is returned.
+ *
+ * The user is responsible for destroying each returned message.
+ *
+ * @param msgs the array where to store the pointers to the returned messages.
+ * @param maxMsgs the number of elements of the `msgs` array.
+ * @param count the location where to store the number of returned messages.
+ * @param sub the pointer to the #natsSubscription object.
+ * @param timeout time, in milliseconds, after which this call will return
+ * #NATS_TIMEOUT if no message is available.
+ */
+NATS_EXTERN natsStatus
+natsSubscription_NextMsgs(natsMsg **msgs, int maxMsgs, int *count,
+                          natsSubscription *sub, int64_t timeout);
+
 /** \brief Unsubscribes.
  *
  * Removes interest on the subject. Asynchronous subscription may still have
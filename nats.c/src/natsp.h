@@ -36,6 +36,7 @@
 #include "err.h"
 #include "nats.h"
 #include "buf.h"
+#include "segbuf.h"
 #include "parser.h"
 #include "timer.h"
 #include "url.h"
@@ -43,6 +44,7 @@
 #include "msg.h"
 #include "asynccb.h"
 #include "hash.h"
+#include "subtable.h"
 #include "stats.h"
 #include "natstime.h"
 #include "nuid.h"
@@ -79,6 +81,7 @@
 #define PERMISSIONS_ERR             "Permissions Violation"
 #define AUTHORIZATION_ERR           "Authorization Violation"
 #define AUTHENTICATION_EXPIRED_ERR  "User Authentication Expired"
+#define INLINE_DLV_BLOCKING_ERR     "Illegal to block on the connection from an inline subscription callback"
 
 #define _CRLF_LEN_          (2)
 #define _SPC_LEN_           (1)
@@ -235,6 +238,19 @@ struct __natsOptions
     natsConnectionHandler   connectedCb;
     void                    *connectedCbClosure;
 
+    // Limit on the number of bytes buffered for sending, and what
+    // to do when a publish call would exceed it.
+    int64_t                 maxOutboundBytes;
+    natsOutboundPolicy      outboundPolicy;
+
+    int64_t                 outboundHighWatermark;
+    natsConnectionHandler   outboundHighCb;
+    void                    *outboundHighCbClosure;
+
+    int64_t                 outboundLowWatermark;
+    natsConnectionHandler   outboundLowCb;
+    void                    *outboundLowCbClosure;
+
     natsErrHandler          asyncErrCb;
     void                    *asyncErrCbClosure;
 
@@ -259,6 +275,34 @@ struct __natsOptions
     // not rely on the flusher.
     bool                    sendAsap;
 
+    // If set to true, publish calls append to per-thread staging
+    // areas that are moved to the connection's buffer by the flusher.
+    bool                    concurrentPublish;
+
+    // Controls how long the flusher waits for more data before flushing.
+    natsFlushPolicy         flushPolicy;
+    int64_t                 flushMaxDelay;
+    int                     flushMinBytes;
+
+    // If set to true, received messages point into ref-counted read
+    // buffers instead of being copied.
+    bool                    zeroCopyRecv;
+
+    // If set to true, received messages are allocated from a pool that
+    // keeps at most msgPoolMaxFree free messages per size class.
+    bool                    msgPool;
+    int                     msgPoolMaxFree;
+
+    // If set to true, received messages are freed by the thread calling
+    // natsMsg_Destroy() instead of the garbage collector.
+    bool                    inlineMsgFree;
+
+    // Time (in microseconds) the reading thread, delivery threads and
+    // NextMsg callers spin before waiting, and value of SO_BUSY_POLL
+    // for the socket.
+    int64_t                 busyPoll;
+    int                     sockBusyPoll;
+
     // NoEcho configures whether the server will echo back messages
     // that are sent on this connection if we also have matching subscriptions.
     // Note this is supported on servers >= version 1.2. Proto 1 or greater.
@@ -287,26 +331,73 @@ struct __natsOptions
     userCreds               *userCreds;
 };
 
-typedef struct __natsMsgList
-{
-    natsMsg     *head;
-    natsMsg     *tail;
-    int         msgs;
-    int         bytes;
+// Maximum number of timer threads, see nats_SetTimerPoolSize().
+#define NATS_LIB_MAX_TIMER_THREADS  (64)
 
-} natsMsgList;
+// Maximum number of messages a delivery pool worker delivers for a
+// subscription before moving to the next subscription in its run queue.
+#define NATS_LIB_DLV_QUANTUM    (64)
 
 typedef struct __natsMsgDlvWorker
 {
+    // Protects the delivery state of the subscriptions that have been
+    // assigned to this worker (see natsSubscription's 'libDlvWorker'),
+    // regardless of the worker that delivers their messages.
     natsMutex       *lock;
-    natsCondition   *cond;
+
+    // Index of this worker in the pool.
+    int             idx;
     natsThread      *thread;
-    bool            inWait;
+
+    // Protects the run queue, 'shutdown' and statistics. No other lock
+    // is acquired while holding it.
+    natsMutex       *runLock;
+    natsCondition   *cond;
+
+    // Subscriptions that have messages to deliver, linked by their
+    // 'dlvNext' field.
+    struct __natsSubscription   *runHead;
+    struct __natsSubscription   *runTail;
+    volatile int    runLen;
+
+    // Set while the worker waits on 'cond'.
+    int             inWait;
+    // Set while the worker delivers messages of a subscription.
+    volatile bool   running;
     bool            shutdown;
-    natsMsgList     msgList;
+
+    // Number of subscriptions that have this worker as home.
+    natsAtomicInt   numSubs;
+
+    // Time spent delivering messages (in nanoseconds), number of messages
+    // delivered and subscriptions taken from other workers.
+    int64_t         busyTime;
+    uint64_t        delivered;
+    uint64_t        steals;
 
 } natsMsgDlvWorker;
 
+// A delivery thread of a subscription created with
+// natsConnection_SubscribeParallel().
+typedef struct __natsSubLane
+{
+    struct __natsSubscription   *sub;
+    natsThread                  *thread;
+
+    // When messages are ordered, the lane has its own queue, and waits on
+    // its own condition variable (with the subscription's lock). Otherwise,
+    // all lanes consume the subscription's queue.
+    natsMsgQueue                msgQ;
+    natsCondition               *cond;
+    natsAtomicInt               inWait;
+
+    // Messages being assigned to this lane. Used only by the connection's
+    // reading thread.
+    struct __natsMsg            *dispatchHead;
+    struct __natsMsg            *dispatchTail;
+
+} natsSubLane;
+
 struct __natsSubscription
 {
     natsMutex                   *mu;
@@ -322,19 +413,25 @@ struct __natsSubscription
     // have reached the max number of messages.
     uint64_t                    delivered;
 
-    // The list of messages waiting to be delivered to the callback (or
-    // returned from NextMsg).
-    natsMsgList                 msgList;
+    // The queue of messages waiting to be delivered to the callback (or
+    // returned from NextMsg), or to be delivered by the library pool.
+    natsMsgQueue                msgQ;
+
+    // Number of messages and bytes received and not yet delivered.
+    // Updated atomically.
+    natsAtomicInt               pendingMsgs;
+    natsAtomicInt               pendingBytes;
 
-    // True if msgList.count is over pendingMax
+    // True if pendingMsgs is over pendingMax
     bool                        slowConsumer;
 
     // Condition variable used to wait for message delivery.
     natsCondition               *cond;
 
     // This is > 0 when the delivery thread (or NextMsg) goes into a
-    // condition wait.
-    int                         inWait;
+    // condition wait. Producers check it (without the lock) after pushing
+    // to 'msgQ' to decide if they need to signal.
+    natsAtomicInt               inWait;
 
     // The subscriber is closed (or closing).
     bool                        closed;
@@ -370,21 +467,75 @@ struct __natsSubscription
     natsThread                  *deliverMsgsThread;
 
     // If message delivery is done by the library instead, this is the
-    // reference to the worker handling this subscription.
+    // worker the subscription was assigned to. Its lock protects the
+    // delivery state, and it does not change.
     natsMsgDlvWorker            *libDlvWorker;
 
+    // Worker whose run queue this subscription is added to when it has
+    // messages to deliver. It changes when the subscription is taken by
+    // another worker, or if its worker is parked after the pool shrinks.
+    natsMsgDlvWorker * volatile dlvHome;
+
+    // Set to 1 (with a reference on the subscription) when it is added to
+    // a worker's run queue, and back to 0 by the worker once the queue is
+    // empty. Only one worker delivers the messages of a subscription at a
+    // time, which preserves ordering.
+    natsAtomicInt               dlvScheduled;
+    struct __natsSubscription   *dlvNext;
+
+    // Set once the subscription no longer counts in its home's 'numSubs'.
+    bool                        dlvDone;
+
     // Message callback and closure (for async subscription).
     natsMsgHandler              msgCb;
     void                        *msgCbClosure;
 
+    // Set instead of msgCb for subscriptions created with
+    // natsConnection_SubscribeBatch(). Messages are collected in
+    // 'msgBatch' (of 'maxBatch' elements) and passed to this callback.
+    natsMsgBatchHandler         msgBatchCb;
+    natsMsg                     **msgBatch;
+    int                         maxBatch;
+    int64_t                     batchLinger;
+
+    // Delivery threads of subscriptions created with
+    // natsConnection_SubscribeParallel(). 'lanesRunning' is the number of
+    // lanes that have not exited yet, and 'lanesDrained' the number of lanes
+    // that have no more messages to deliver after the subscription started
+    // to drain.
+    natsSubLane                 *lanes;
+    int                         numLanes;
+    natsParallelOrder           laneOrder;
+    natsMsgKeyHandler           laneKeyCb;
+    int                         lanesRunning;
+    int                         lanesDrained;
+
+    // Time (in nanoseconds) the delivery thread, or NextMsg, spins on the
+    // queue before waiting on the condition variable. From the
+    // connection's busy poll option.
+    int64_t                     busyPoll;
+
+    // Set for subscriptions created with natsConnection_SubscribeInline().
+    // Messages are passed to the callback by the thread that reads them
+    // from the socket, there is no delivery thread nor message queue.
+    bool                        inlineDlv;
+
     int64_t                     timeout;
     natsTimer                   *timeoutTimer;
     bool                        timedOut;
     bool                        timeoutSuspended;
 
-    // Pending limits, etc..
-    int                         msgsMax;
-    int                         bytesMax;
+    // Time (in milliseconds) the library's delivery worker last returned
+    // from the callback with no message pending. The timeout timer is not
+    // reset for each message: when it fires, it is re-armed if there has
+    // been activity since it was set.
+    int64_t                     lastActivity;
+
+    // Pending limits, etc.. The max pending counts are raised by the
+    // thread dispatching messages without holding the subscription's lock,
+    // and reset by natsSubscription_ClearMaxPending(), so they are atomic.
+    natsAtomicInt               msgsMax;
+    natsAtomicInt               bytesMax;
     int                         msgsLimit;
     int                         bytesLimit;
     int64_t                     dropped;
@@ -393,6 +544,11 @@ struct __natsSubscription
     natsOnCompleteCB            onCompleteCB;
     void                        *onCompleteCBClosure;
 
+    // Used by the connection's subscription table to defer the release
+    // of its reference until the read loop can no longer use it.
+    struct __natsSubscription   *retiredNext;
+    int                         retiredSeq;
+
 };
 
 typedef struct __natsPong
@@ -433,6 +589,13 @@ typedef struct __natsSockCtx
 
     int             orderIP; // possible values: 0,4,6,46,64
 
+    // Time (in nanoseconds) during which a read that would block is
+    // retried before waiting for the socket to be readable.
+    int64_t         busyPoll;
+
+    // If > 0, value of the SO_BUSY_POLL socket option.
+    int             sockBusyPoll;
+
 } natsSockCtx;
 
 typedef struct __respInfo
@@ -446,6 +609,21 @@ typedef struct __respInfo
 
 } respInfo;
 
+// Number of staging areas used when the ConcurrentPublish option is set.
+#define NATS_PUB_STAGES_COUNT   (32)
+
+typedef struct __natsPubStage
+{
+    natsMutex           *mu;
+    natsBuffer          *buf;
+    natsBuffer          *spare;
+    bool                open;
+    int64_t             maxPayload;
+    uint64_t            msgs;
+    uint64_t            bytes;
+
+} natsPubStage;
+
 struct __natsConnection
 {
     natsMutex           *mu;
@@ -459,18 +637,36 @@ struct __natsConnection
 
     natsSrvPool         *srvPool;
 
-    natsBuffer          *pending;
+    natsSegBuffer       *pending;
     bool                usePending;
+    // Set while the pending buffer is sent after a reconnect, which is
+    // done without holding the connection lock.
+    bool                replaying;
 
     natsBuffer          *bw;
     natsBuffer          *scratch;
 
+    // When the flusher thread is used, it swaps 'bw' with 'bwBack' and
+    // writes the latter without holding the connection lock. The write
+    // mutex serializes socket writes and is acquired while holding the
+    // connection lock (never the other way around).
+    natsBuffer          *bwBack;
+    natsMutex           *writeMu;
+    // Status of the last write of 'bwBack', reported to the publish calls
+    // that waited for it to complete.
+    natsStatus          bwBackStatus;
+
     natsServerInfo      info;
 
     int64_t             ssid;
     natsHash            *subs;
     natsMutex           *subsMu;
 
+    // Same subscriptions than 'subs', indexed by sid, used by the read
+    // loop to lookup subscriptions without holding 'subsMu'. It is
+    // modified under 'subsMu'.
+    natsSubTable        *subTable;
+
     natsConnStatus      status;
     bool                initc; // true if the connection is performing the initial connect
     bool                ar;    // abort reconnect attempts
@@ -479,6 +675,8 @@ struct __natsConnection
     char                errStr[256];
 
     natsParser          *ps;
+    // Pool received messages are allocated from, if enabled.
+    natsMsgPool         *msgPool;
     natsTimer           *ptmr;
     int                 pout;
 
@@ -490,6 +688,14 @@ struct __natsConnection
     natsCondition       *flusherCond;
     bool                flusherSignaled;
     bool                flusherStop;
+    // Set while the flusher waits for 'flusherWakeBytes' to be buffered.
+    bool                flusherWaiting;
+    int                 flusherWakeBytes;
+    // Used by the adaptive flush policy to estimate the publish rate.
+    int64_t             flushRateTime;
+    uint64_t            flushRateBytes;
+    uint64_t            flushRateMsgs;
+    int64_t             flushRate;      // bytes per millisecond
 
     natsThread          *reconnectThread;
     int                 inReconnect;
@@ -497,6 +703,14 @@ struct __natsConnection
 
     natsStatistics      stats;
 
+    // Used with the MaxOutboundBytes option and outbound watermarks.
+    natsCondition       *outboundCond;
+    int                 outboundWaiters;
+    bool                outboundHigh;
+
+    // Only set when the ConcurrentPublish option is enabled.
+    natsPubStage        *pubStages;
+
     natsTimer           *drainTimer;
     int64_t             drainDeadline;
 
@@ -525,6 +739,17 @@ struct __natsConnection
     } el;
 };
 
+struct __natsPublisher
+{
+    natsConnection      *nc;
+
+    // Pre-encoded "PUB <subject> [<reply> ]" protocol prefix. The buffer
+    // has room for the payload size and CRLF, which are added (under the
+    // connection lock) for each published message.
+    char                *hdr;
+    int                 prefixLen;
+};
+
 //
 // Library
 //
@@ -538,6 +763,10 @@ natsLib_Retain(void);
 void
 natsLib_Release(void);
 
+// Assigns the timer to one of the library's timer threads.
+void
+nats_assignTimer(natsTimer *t);
+
 void
 nats_resetTimer(natsTimer *t, int64_t newInterval);
 
@@ -548,9 +777,9 @@ nats_stopTimer(natsTimer *t);
 int
 nats_getTimersCount(void);
 
-// Returns the number of timers actually in the list. This should be
-// equal to nats_getTimersCount() or nats_getTimersCount() - 1 when a
-// timer thread is invoking a timer's callback.
+// Returns the number of timers actually in the timer wheels. This should
+// be equal to nats_getTimersCount() minus the number of timers whose
+// callback is being invoked by a timer thread.
 int
 nats_getTimersCountInList(void);
 
@@ -569,6 +798,9 @@ natsInbox_init(char *inbox, int inboxLen);
 natsStatus
 natsLib_msgDeliveryPostControlMsg(natsSubscription *sub);
 
+void
+natsLib_msgDeliverySchedule(natsSubscription *sub);
+
 natsStatus
 natsLib_msgDeliveryAssignWorker(natsSubscription *sub);
 
@@ -579,11 +811,23 @@ int64_t
 natsLib_defaultWriteDeadline(void);
 
 void
-natsLib_getMsgDeliveryPoolInfo(int *maxSize, int *size, int *idx, natsMsgDlvWorker ***workersArray);
+natsLib_getMsgDeliveryPoolInfo(int *maxSize, int *size, natsMsgDlvWorker ***workersArray);
 
 void
 nats_setNATSThreadKey(void);
 
+int
+nats_getThreadIndex(void);
+
+// Sets the connection whose inline subscription callbacks are being
+// invoked by the current thread (NULL when done), so that blocking calls
+// on this connection can be rejected from those callbacks.
+void
+nats_setInlineDeliveryConn(natsConnection *nc);
+
+bool
+nats_isInlineDeliveryConn(natsConnection *nc);
+
 //
 // Threads
 //
@@ -58,11 +58,69 @@ nats_NowInNanoSeconds(void)
 #endif
 }
 
+#if defined(_WIN32)
+static LARGE_INTEGER qpcFreq;
+#elif defined(NATS_MONOTONIC_CLOCK)
+static int64_t
+_clockNow(clockid_t clock)
+{
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0)
+        abort();
+    return ((int64_t)ts.tv_sec) * 1000000000L + ((int64_t)ts.tv_nsec);
+}
+#endif
+
+int64_t
+nats_monotonicNow(void)
+{
+#ifdef _WIN32
+    return (int64_t) GetTickCount64();
+#elif defined(NATS_MONOTONIC_CLOCK)
+    return _clockNow(NATS_MONOTONIC_CLOCK) / 1000000;
+#else
+    return nats_Now();
+#endif
+}
+
+int64_t
+nats_monotonicNowInNanoSeconds(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+
+    // The frequency is fixed at boot, so the race is harmless.
+    if (qpcFreq.QuadPart == 0)
+        QueryPerformanceFrequency(&qpcFreq);
+
+    QueryPerformanceCounter(&counter);
+    return (int64_t) ((counter.QuadPart / qpcFreq.QuadPart) * 1000000000L
+                      + ((counter.QuadPart % qpcFreq.QuadPart) * 1000000000L) / qpcFreq.QuadPart);
+#elif defined(NATS_MONOTONIC_CLOCK)
+    return _clockNow(NATS_MONOTONIC_CLOCK);
+#else
+    return nats_NowInNanoSeconds();
+#endif
+}
+
+int64_t
+nats_coarseNow(void)
+{
+#ifdef _WIN32
+    // GetTickCount64() is already cheap, with a precision of 10 to 16ms.
+    return (int64_t) GetTickCount64();
+#elif defined(NATS_MONOTONIC_CLOCK)
+    return _clockNow(NATS_MONOTONIC_COARSE_CLOCK) / 1000000;
+#else
+    return nats_Now();
+#endif
+}
+
 void
 natsDeadline_Init(natsDeadline *deadline, int64_t timeout)
 {
     deadline->active          = true;
-    deadline->absoluteTime    = nats_Now() + timeout;
+    deadline->absoluteTime    = nats_coarseNow() + timeout;
 }
 
 void
@@ -79,7 +137,7 @@ natsDeadline_GetTimeout(natsDeadline *deadline)
     if (!(deadline->active))
         return -1;
 
-    timeout = (int) (deadline->absoluteTime - nats_Now());
+    timeout = (int) (deadline->absoluteTime - nats_coarseNow());
     if (timeout < 0)
         timeout = 0;
 
@@ -17,6 +17,23 @@
 
 #include "natsp.h"
 
+#if !defined(_WIN32)
+#include <time.h>
+
+// Clocks used by nats_monotonicNow() and nats_coarseNow(). The coarse
+// clock must have the same time base, so that both can be compared.
+#if defined(__APPLE__) && defined(CLOCK_MONOTONIC_RAW_APPROX)
+#define NATS_MONOTONIC_CLOCK        CLOCK_MONOTONIC_RAW
+#define NATS_MONOTONIC_COARSE_CLOCK CLOCK_MONOTONIC_RAW_APPROX
+#elif defined(CLOCK_MONOTONIC_COARSE)
+#define NATS_MONOTONIC_CLOCK        CLOCK_MONOTONIC
+#define NATS_MONOTONIC_COARSE_CLOCK CLOCK_MONOTONIC_COARSE
+#elif defined(CLOCK_MONOTONIC)
+#define NATS_MONOTONIC_CLOCK        CLOCK_MONOTONIC
+#define NATS_MONOTONIC_COARSE_CLOCK CLOCK_MONOTONIC
+#endif
+#endif
+
 typedef struct __natsDeadline
 {
     int64_t             absoluteTime;
@@ -24,6 +41,22 @@ typedef struct __natsDeadline
 
 } natsDeadline;
 
+// Returns a monotonic time, in milliseconds, which is not affected by
+// changes of the system clock. It is used for all internal deadlines and
+// timers (including natsCondition_AbsoluteTimedWait()), but has no relation
+// with the EPOCH, unlike nats_Now().
+int64_t
+nats_monotonicNow(void);
+
+// Same than nats_monotonicNow() but in nanoseconds.
+int64_t
+nats_monotonicNowInNanoSeconds(void);
+
+// Cheaper version of nats_monotonicNow(), for hot paths that can live with
+// a precision of a few milliseconds. It has the same time base.
+int64_t
+nats_coarseNow(void);
+
 void
 natsDeadline_Init(natsDeadline *deadline, int64_t timeout);
 
@@ -966,6 +966,137 @@ natsOptions_SetSendAsap(natsOptions *opts, bool sendAsap)
     return NATS_OK;
 }
 
+natsStatus
+natsOptions_SetConcurrentPublish(natsOptions *opts, bool concurrent)
+{
+    LOCK_AND_CHECK_OPTIONS(opts, 0);
+    opts->concurrentPublish = concurrent;
+    UNLOCK_OPTS(opts);
+
+    return NATS_OK;
+}
+
+natsStatus
+natsOptions_SetFlushPolicy(natsOptions *opts, natsFlushPolicy policy,
+                           int64_t maxDelay, int minBytes)
+{
+    LOCK_AND_CHECK_OPTIONS(opts,
+                           (((policy != NATS_FLUSH_POLICY_FIXED)
+                                && (policy != NATS_FLUSH_POLICY_ADAPTIVE))
+                            || (maxDelay < 0)
+                            || (minBytes < 0)));
+
+    opts->flushPolicy   = policy;
+    opts->flushMaxDelay = maxDelay;
+    opts->flushMinBytes = minBytes;
+
+    UNLOCK_OPTS(opts);
+
+    return NATS_OK;
+}
+
+natsStatus
+natsOptions_SetMaxOutboundBytes(natsOptions *opts, int64_t maxBytes,
+                                natsOutboundPolicy policy)
+{
+    LOCK_AND_CHECK_OPTIONS(opts,
+                           ((maxBytes < 0)
+                            || ((policy != NATS_OUTBOUND_POLICY_BLOCK)
+                                && (policy != NATS_OUTBOUND_POLICY_FAIL)
+                                && (policy != NATS_OUTBOUND_POLICY_DROP))));
+
+    opts->maxOutboundBytes = maxBytes;
+    opts->outboundPolicy   = policy;
+
+    UNLOCK_OPTS(opts);
+
+    return NATS_OK;
+}
+
+natsStatus
+natsOptions_SetOutboundHighWatermarkCB(natsOptions *opts, int64_t bytes,
+                                       natsConnectionHandler highCb,
+                                       void *closure)
+{
+    LOCK_AND_CHECK_OPTIONS(opts, (bytes < 0));
+
+    opts->outboundHighWatermark = bytes;
+    opts->outboundHighCb        = highCb;
+    opts->outboundHighCbClosure = closure;
+
+    UNLOCK_OPTS(opts);
+
+    return NATS_OK;
+}
+
+natsStatus
+natsOptions_SetOutboundLowWatermarkCB(natsOptions *opts, int64_t bytes,
+                                      natsConnectionHandler lowCb,
+                                      void *closure)
+{
+    LOCK_AND_CHECK_OPTIONS(opts, (bytes < 0));
+
+    opts->outboundLowWatermark = bytes;
+    opts->outboundLowCb        = lowCb;
+    opts->outboundLowCbClosure = closure;
+
+    UNLOCK_OPTS(opts);
+
+    return NATS_OK;
+}
+
+natsStatus
+natsOptions_SetZeroCopyReceive(natsOptions *opts, bool zeroCopy)
+{
+    LOCK_AND_CHECK_OPTIONS(opts, 0);
+    opts->zeroCopyRecv = zeroCopy;
+    UNLOCK_OPTS(opts);
+
+    return NATS_OK;
+}
+
+natsStatus
+natsOptions_SetMsgPool(natsOptions *opts, bool enabled, int maxFree)
+{
+    LOCK_AND_CHECK_OPTIONS(opts, (maxFree < 0));
+
+    opts->msgPool        = enabled;
+    opts->msgPoolMaxFree = maxFree;
+
+    UNLOCK_OPTS(opts);
+
+    return NATS_OK;
+}
+
+natsStatus
+natsOptions_SetInlineMsgFree(natsOptions *opts, bool inlineFree)
+{
+    LOCK_AND_CHECK_OPTIONS(opts, 0);
+    opts->inlineMsgFree = inlineFree;
+    UNLOCK_OPTS(opts);
+
+    return NATS_OK;
+}
+
+natsStatus
+natsOptions_SetBusyPoll(natsOptions *opts, int64_t spin, int sockBusyPoll)
+{
+#if !defined(SO_BUSY_POLL)
+    if (sockBusyPoll > 0)
+        return nats_setError(NATS_INVALID_ARG, "%s",
+                             "SO_BUSY_POLL is not supported on this platform");
+#endif
+
+    LOCK_AND_CHECK_OPTIONS(opts, ((spin < 0) || (sockBusyPoll < 0)));
+
+    opts->busyPoll     = spin;
+    opts->sockBusyPoll = sockBusyPoll;
+
+    UNLOCK_OPTS(opts);
+
+    return NATS_OK;
+}
+
 natsStatus
 natsOptions_SetNoEcho(natsOptions *opts, bool noEcho)
 {
@@ -1252,6 +1383,8 @@ natsOptions_Create(natsOptions **newOpts)
     opts->timeout        = NATS_OPTS_DEFAULT_TIMEOUT;
     opts->libMsgDelivery = natsLib_isLibHandlingMsgDeliveryByDefault();
     opts->writeDeadline  = natsLib_defaultWriteDeadline();
+    opts->flushPolicy    = NATS_FLUSH_POLICY_FIXED;
+    opts->flushMaxDelay  = NATS_OPTS_DEFAULT_FLUSH_MAX_DELAY;
 
     *newOpts = opts;
 
@@ -32,6 +32,8 @@
 #define NATS_OPTS_DEFAULT_IO_BUF_SIZE         (32 * 1024)         // 32 KB
 #define NATS_OPTS_DEFAULT_MAX_PENDING_MSGS    (65536)
 #define NATS_OPTS_DEFAULT_RECONNECT_BUF_SIZE  (8 * 1024 * 1024)   // 8 MB
+#define NATS_OPTS_DEFAULT_FLUSH_MAX_DELAY     (1)                 // 1 millisecond
+#define NATS_OPTS_DEFAULT_MSG_POOL_MAX_FREE   (1024)
 
 natsOptions*
 natsOptions_clone(natsOptions *opts);
@@ -19,6 +19,24 @@
 #include "util.h"
 #include "mem.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define NATS_PARSER_USE_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+static int
+_ctz(unsigned int x)
+{
+    unsigned long r = 0;
+
+    _BitScanForward(&r, (unsigned long) x);
+    return (int) r;
+}
+#else
+#define _ctz(x) __builtin_ctz(x)
+#endif
+#endif
+
 // cloneMsgArg is used when the split buffer scenario has the pubArg in the existing read buffer, but
 // we need to hold onto it into the next read.
 static natsStatus
@@ -81,6 +99,48 @@ struct slice
     int     len;
 };
 
+// Sets the message arguments from the 3 (no reply) or 4 slices of a
+// MSG protocol line.
+static natsStatus
+_setMsgArgs(natsConnection *nc, struct slice *slices, int count)
+{
+    natsStatus  s           = NATS_OK;
+    int         maSizeIndex = 2;
+
+    s = natsBuf_InitWithBackend(&(nc->ps->ma.subjectRec),
+                                slices[0].start,
+                                slices[0].len,
+                                slices[0].len);
+    if (s == NATS_OK)
+    {
+        nc->ps->ma.subject = &(nc->ps->ma.subjectRec);
+
+        nc->ps->ma.sid   = nats_ParseInt64(slices[1].start, slices[1].len);
+
+        if (count == 3)
+        {
+            nc->ps->ma.reply = NULL;
+        }
+        else
+        {
+            s = natsBuf_InitWithBackend(&(nc->ps->ma.replyRec),
+                                        slices[2].start,
+                                        slices[2].len,
+                                        slices[2].len);
+            if (s == NATS_OK)
+            {
+                nc->ps->ma.reply = &(nc->ps->ma.replyRec);
+                maSizeIndex = 3;
+            }
+        }
+    }
+    if (s == NATS_OK)
+        nc->ps->ma.size = (int) nats_ParseInt64(slices[maSizeIndex].start,
+                                                slices[maSizeIndex].len);
+
+    return s;
+}
+
 static natsStatus
 _processMsgArgs(natsConnection *nc, char *buf, int bufLen)
 {
@@ -138,38 +198,7 @@ _processMsgArgs(natsConnection *nc, char *buf, int bufLen)
     }
     if ((s == NATS_OK) && ((index == 3) || (index == 4)))
     {
-        int maSizeIndex = 2;
-
-        s = natsBuf_InitWithBackend(&(nc->ps->ma.subjectRec),
-                                    slices[0].start,
-                                    slices[0].len,
-                                    slices[0].len);
-        if (s == NATS_OK)
-        {
-            nc->ps->ma.subject = &(nc->ps->ma.subjectRec);
-
-            nc->ps->ma.sid   = nats_ParseInt64(slices[1].start, slices[1].len);
-
-            if (index == 3)
-            {
-                nc->ps->ma.reply = NULL;
-            }
-            else
-            {
-                s = natsBuf_InitWithBackend(&(nc->ps->ma.replyRec),
-                                            slices[2].start,
-                                            slices[2].len,
-                                            slices[2].len);
-                if (s == NATS_OK)
-                {
-                    nc->ps->ma.reply = &(nc->ps->ma.replyRec);
-                    maSizeIndex = 3;
-                }
-            }
-        }
-        if (s == NATS_OK)
-            nc->ps->ma.size = (int) nats_ParseInt64(slices[maSizeIndex].start,
-                                                    slices[maSizeIndex].len);
+        s = _setMsgArgs(nc, slices, index);
     }
     else
     {
@@ -200,9 +229,161 @@ _processMsgArgs(natsConnection *nc, char *buf, int bufLen)
     return s;
 }
 
+// Adds the slice between the separators at 'last' and 'idx'. Makes the
+// calling function return -1 if there are already 'maxSlices' slices, or
+// if the separators are consecutive (other than "\r\n"), since the state
+// machine does not handle those the same way.
+#define _ADD_SLICE(buf, last, idx, slices, maxSlices, count) \
+    if ((idx) > (last) + 1) \
+    { \
+        if (*(count) == (maxSlices)) \
+            return -1; \
+        (slices)[*(count)].start = (buf) + (last) + 1; \
+        (slices)[*(count)].len   = (idx) - (last) - 1; \
+        (*(count))++; \
+    } \
+    else if (((last) < 0) || ((buf)[(last)] != '\r') || ((buf)[(idx)] != '\n')) \
+    { \
+        return -1; \
+    }
+
+// Splits the protocol line that starts at 'buf' into at most 'maxSlices'
+// slices separated by a space, tab or '\r', up to the first '\n'.
+// Returns the index of the '\n', or -1 if the line is not complete in
+// the buffer or is not in the expected form.
+// With SSE2, the separators are found 16 bytes at a time.
+static int
+_splitLine(char *buf, int bufLen, struct slice *slices, int maxSlices, int *count)
+{
+    int     last = -1;
+    int     i    = 0;
+    char    b;
+
+    *count = 0;
+
+#ifdef NATS_PARSER_USE_SSE2
+    {
+        const __m128i   sp  = _mm_set1_epi8(' ');
+        const __m128i   tab = _mm_set1_epi8('\t');
+        const __m128i   cr  = _mm_set1_epi8('\r');
+        const __m128i   lf  = _mm_set1_epi8('\n');
+        __m128i         v;
+        unsigned int    seps;
+        unsigned int    lfs;
+        int             idx;
+
+        for (; i + 16 <= bufLen; i += 16)
+        {
+            v    = _mm_loadu_si128((const __m128i*) (buf + i));
+            lfs  = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(v, lf));
+            seps = (unsigned int) _mm_movemask_epi8(
+                        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sp),
+                                                  _mm_cmpeq_epi8(v, tab)),
+                                     _mm_cmpeq_epi8(v, cr)));
+            seps |= lfs;
+
+            while (seps != 0)
+            {
+                idx = i + _ctz(seps);
+                _ADD_SLICE(buf, last, idx, slices, maxSlices, count);
+                if (buf[idx] == '\n')
+                    return idx;
+
+                last = idx;
+                // Clear the lowest bit.
+                seps &= (seps - 1);
+            }
+        }
+    }
+#endif
+
+    for (; i < bufLen; i++)
+    {
+        b = buf[i];
+        if ((b == ' ') || (b == '\t') || (b == '\r') || (b == '\n'))
+        {
+            _ADD_SLICE(buf, last, i, slices, maxSlices, count);
+            if (b == '\n')
+                return i;
+
+            last = i;
+        }
+    }
+
+    return -1;
+}
+
+// Fast path for a MSG frame that starts at 'buf[*pos]' (the 'M' has been
+// checked by the caller). When the whole protocol line is in the buffer, it
+// is processed in one pass. If the payload is in the buffer too, the message
+// is processed and '*pos' is set to the end of the frame. Otherwise, the
+// parser is put in the state the state machine would be in after processing
+// the protocol line. Returns false without changing the parser state if the
+// line is not complete or not what is expected, in which case the caller
+// falls back to the state machine (which reports errors).
+static bool
+_parseMsgFast(natsConnection *nc, char *buf, int bufLen, int *pos, natsStatus *status)
+{
+    natsParser      *ps    = nc->ps;
+    int             start  = *pos;
+    int             count  = 0;
+    int             lineEnd;
+    int             afterSpace;
+    int64_t         sid;
+    int             size;
+    struct slice    slices[4];
+
+    if ((ps->argBuf != NULL)
+        || (bufLen - start < 4)
+        || ((buf[start+1] != 'S') && (buf[start+1] != 's'))
+        || ((buf[start+2] != 'G') && (buf[start+2] != 'g'))
+        || ((buf[start+3] != ' ') && (buf[start+3] != '\t')))
+    {
+        return false;
+    }
+
+    start += 4;
+    lineEnd = _splitLine(buf + start, bufLen - start, slices, 4, &count);
+    if ((lineEnd < 0) || (count < 3))
+        return false;
+
+    sid  = nats_ParseInt64(slices[1].start, slices[1].len);
+    size = (int) nats_ParseInt64(slices[count-1].start, slices[count-1].len);
+    if ((sid < 0) || (size < 0))
+        return false;
+
+    *status = _setMsgArgs(nc, slices, count);
+    if (*status != NATS_OK)
+        return true;
+
+    afterSpace = start + lineEnd + 1;
+
+    ps->drop = 0;
+
+    if ((afterSpace + size + 2 <= bufLen)
+        && (buf[afterSpace + size] == '\r')
+        && (buf[afterSpace + size + 1] == '\n'))
+    {
+        *status = natsConn_processMsg(nc, buf + afterSpace, size);
+
+        ps->afterSpace  = afterSpace + size + 2;
+        ps->state       = OP_START;
+        *pos            = ps->afterSpace - 1;
+    }
+    else
+    {
+        // Same than when the state machine reaches the end of the line.
+        ps->afterSpace  = afterSpace;
+        ps->state       = MSG_PAYLOAD;
+        *pos            = afterSpace + size - 1;
+    }
+
+    return true;
+}
+
 // parse is the fast protocol parser engine.
-natsStatus
-natsParser_Parse(natsConnection *nc, char* buf, int bufLen)
+static natsStatus
+_parse(natsConnection *nc, char* buf, int bufLen)
 {
     natsStatus  s = NATS_OK;
     int         i;
@@ -220,7 +401,8 @@ natsParser_Parse(natsConnection *nc, char* buf, int bufLen)
                 {
                     case 'M':
                     case 'm':
-                        nc->ps->state = OP_M;
+                        if (!_parseMsgFast(nc, buf, bufLen, &i, &s))
+                            nc->ps->state = OP_M;
                         break;
                     case 'P':
                     case 'p':
@@ -870,6 +1052,32 @@ parseErr:
     return s;
 }
 
+natsStatus
+natsParser_Parse(natsConnection *nc, char* buf, int bufLen)
+{
+    natsStatus s;
+
+    // Subscriptions are looked up in the table without lock. Those that
+    // are removed while parsing are released after natsSubTable_ExitRead().
+    natsSubTable_EnterRead(nc->subTable);
+
+    s = _parse(nc, buf, bufLen);
+
+    natsSubTable_ExitRead(nc->subTable);
+
+    // Messages parsed from this buffer are dispatched even on error.
+    natsConn_dispatchMsgs(nc);
+
+    if (natsSubTable_HasRetired(nc->subTable))
+    {
+        natsMutex_Lock(nc->subsMu);
+        natsSubTable_Reclaim(nc->subTable);
+        natsMutex_Unlock(nc->subsMu);
+    }
+
+    return s;
+}
+
 natsStatus
 natsParser_Create(natsParser **newParser)
 {
@@ -68,6 +68,24 @@ typedef struct __natsMsgArg
 
 #define MAX_CONTROL_LINE_SIZE   (1024)
 
+// This is defined in msg.h, which is included after us in natsp.h
+struct __natsMsgSlab;
+struct __natsMsg;
+struct __natsSubscription;
+
+// Maximum number of subscriptions for which messages are batched while
+// parsing a buffer. If more are needed, the batches are dispatched.
+#define NATS_PARSER_MAX_BATCHES (8)
+
+// Messages for a given subscription, parsed from the current buffer.
+typedef struct __natsMsgBatch
+{
+    struct __natsSubscription   *sub;
+    struct __natsMsg            *head;
+    struct __natsMsg            *tail;
+
+} natsMsgBatch;
+
 typedef struct __natsParser
 {
     natsOp      state;
@@ -80,6 +98,23 @@ typedef struct __natsParser
     natsBuffer  *msgBuf;
     char        scratch[MAX_CONTROL_LINE_SIZE];
 
+    // If not NULL, the buffer being parsed belongs to this slab and
+    // messages that are not split can point into it.
+    struct __natsMsgSlab *slab;
+
+    // Messages are added to those batches while parsing a buffer and
+    // dispatched to the subscriptions at the end of natsParser_Parse(),
+    // so that each subscription is locked once per buffer.
+    natsMsgBatch    batches[NATS_PARSER_MAX_BATCHES];
+    int             numBatches;
+
+    // Statistics accumulated while parsing, and added to the connection's
+    // statistics when the batches are dispatched.
+    uint64_t        inMsgs;
+    uint64_t        inBytes;
+    uint64_t        msgPoolHits;
+    uint64_t        msgPoolMisses;
+
 } natsParser;
 
 // This is defined in natsp.h, natsp.h includes us. Alternatively, we can move
@@ -25,35 +25,210 @@ static const char *digits = "0123456789";
 
 #define _publish(n, s, r, d, l) natsConn_publish((n), (s), (r), (d), (l), false)
 
-// _publish is the internal function to publish messages to a nats server.
+// Appends the message to the staging area selected by the calling thread,
+// without acquiring the connection lock. 'staged' is set to false if the
+// message needs to go through the regular path, that is, when staging is
+// disabled (the connection is not connected, or is draining or closed),
+// or when there is not enough room in the staging area.
+static natsStatus
+_stagePublish(natsConnection *nc, const char *subj, int subjLen,
+              const char *reply, int replyLen, natsPublisher *pub,
+              const char *sizeStr, int sizeSize,
+              const natsIOVec *iov, int iovcnt, int dataLen,
+              bool *staged)
+{
+    natsStatus      s       = NATS_OK;
+    natsPubStage    *stage  = NULL;
+    int             msgSize = 0;
+    bool            kick    = false;
+    char            *ptr;
+    int             j;
+
+    stage = &(nc->pubStages[nats_getThreadIndex() % NATS_PUB_STAGES_COUNT]);
+
+    if (pub != NULL)
+        msgSize = pub->prefixLen;
+    else
+        msgSize = _PUB_P_LEN_ + subjLen + 1 + (replyLen > 0 ? replyLen + 1 : 0);
+    msgSize += sizeSize + _CRLF_LEN_ + dataLen + _CRLF_LEN_;
+
+    *staged = false;
+
+    natsMutex_Lock(stage->mu);
+
+    if (!(stage->open) || (msgSize > nc->opts->ioBufSize))
+    {
+        natsMutex_Unlock(stage->mu);
+
+        return NATS_OK;
+    }
+
+    if ((int64_t) dataLen > stage->maxPayload)
+    {
+        natsMutex_Unlock(stage->mu);
+
+        return nats_setError(NATS_MAX_PAYLOAD,
+                             "Payload %d greater than maximum allowed: %" PRId64,
+                             dataLen, stage->maxPayload);
+    }
+
+    if (stage->buf == NULL)
+    {
+        s = natsBuf_Create(&(stage->buf), nc->opts->ioBufSize);
+        if (s == NATS_OK)
+            s = natsBuf_Create(&(stage->spare), nc->opts->ioBufSize);
+        if (s != NATS_OK)
+        {
+            natsBuf_Destroy(stage->buf);
+            stage->buf = NULL;
+            natsMutex_Unlock(stage->mu);
+
+            return NATS_UPDATE_ERR_STACK(s);
+        }
+    }
+
+    // If the stage is full, the message goes through the regular path,
+    // which will first move the content of the stages to the connection.
+    if (msgSize > natsBuf_Available(stage->buf))
+    {
+        natsMutex_Unlock(stage->mu);
+
+        return NATS_OK;
+    }
+
+    kick = (natsBuf_Len(stage->buf) == 0);
+
+    ptr = natsBuf_Data(stage->buf) + natsBuf_Len(stage->buf);
+    if (pub != NULL)
+    {
+        // Only the constant part of the publisher's header is read here.
+        memcpy(ptr, pub->hdr, pub->prefixLen);
+        ptr += pub->prefixLen;
+    }
+    else
+    {
+        memcpy(ptr, _PUB_P_, _PUB_P_LEN_);
+        ptr += _PUB_P_LEN_;
+        memcpy(ptr, subj, subjLen);
+        ptr += subjLen;
+        *(ptr++) = ' ';
+        if (replyLen > 0)
+        {
+            memcpy(ptr, reply, replyLen);
+            ptr += replyLen;
+            *(ptr++) = ' ';
+        }
+    }
+    memcpy(ptr, sizeStr, sizeSize);
+    ptr += sizeSize;
+    memcpy(ptr, _CRLF_, _CRLF_LEN_);
+    ptr += _CRLF_LEN_;
+    for (j=0; j<iovcnt; j++)
+    {
+        memcpy(ptr, iov[j].iov_base, iov[j].iov_len);
+        ptr += iov[j].iov_len;
+    }
+    memcpy(ptr, _CRLF_, _CRLF_LEN_);
+
+    natsBuf_MoveTo(stage->buf, natsBuf_Len(stage->buf) + msgSize);
+
+    stage->msgs++;
+    stage->bytes += (uint64_t) dataLen;
+
+    natsMutex_Unlock(stage->mu);
+
+    *staged = true;
+
+    // Notify the flusher only when the stage was empty, which avoids
+    // acquiring the connection lock for every message.
+    if (kick)
+    {
+        natsConn_Lock(nc);
+        s = natsConn_flushOrKickFlusher(nc);
+        natsConn_Unlock(nc);
+    }
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
+// _publishV is the internal function to publish messages to a nats server.
 // Sends a protocol data message by queueing into the bufio writer
 // and kicking the flusher thread. These writes should be protected.
-natsStatus
-natsConn_publish(natsConnection *nc, const char *subj,
-         const char *reply, const void *data, int dataLen,
-         bool directFlush)
+// The payload is made of 'iovcnt' segments for a total of 'dataLen' bytes.
+// If 'pub' is not NULL, its pre-encoded header is used and 'subj' and
+// 'reply' are ignored.
+static natsStatus
+_publishV(natsConnection *nc, const char *subj, const char *reply,
+          natsPublisher *pub, const natsIOVec *iov, int iovcnt,
+          int dataLen, bool directFlush)
 {
     natsStatus  s = NATS_OK;
     int         msgHdSize = 0;
     char        b[12];
     int         bSize = sizeof(b);
     int         i = bSize;
+    int         j;
     int         subjLen = 0;
     int         replyLen = 0;
     int         sizeSize = 0;
     int         pos = 0;
     bool        reconnecting = false;
+    char        *hdr = NULL;
 
     if (nc == NULL)
         return nats_setDefaultError(NATS_INVALID_ARG);
 
-    if ((subj == NULL)
-        || ((subjLen = (int) strlen(subj)) == 0))
+    if ((pub == NULL)
+        && ((subj == NULL) || ((subjLen = (int) strlen(subj)) == 0)))
     {
         return nats_setDefaultError(NATS_INVALID_SUBJECT);
     }
 
-    replyLen = ((reply != NULL) ? (int) strlen(reply) : 0);
+    if (pub == NULL)
+        replyLen = ((reply != NULL) ? (int) strlen(reply) : 0);
+
+    if (dataLen > 0)
+    {
+        int l;
+
+        for (l = dataLen; l > 0; l /= 10)
+        {
+            i -= 1;
+            b[i] = digits[l%10];
+        }
+    }
+    else
+    {
+        i -= 1;
+        b[i] = digits[0];
+    }
+
+    sizeSize = (bSize - i);
+
+    if (pub != NULL)
+    {
+        msgHdSize = pub->prefixLen + sizeSize + _CRLF_LEN_;
+    }
+    else
+    {
+        msgHdSize = _PUB_P_LEN_
+                    + subjLen + 1
+                    + (replyLen > 0 ? replyLen + 1 : 0)
+                    + sizeSize + _CRLF_LEN_;
+    }
+
+    // When the ConcurrentPublish option is set, try to stage the message
+    // without acquiring the connection lock. Requests that need to be
+    // flushed right away always go through the regular path.
+    if ((nc->pubStages != NULL) && !directFlush)
+    {
+        bool staged = false;
+
+        s = _stagePublish(nc, subj, subjLen, reply, replyLen, pub,
+                          (b+i), sizeSize, iov, iovcnt, dataLen, &staged);
+        if ((s != NATS_OK) || staged)
+            return NATS_UPDATE_ERR_STACK(s);
+    }
 
     natsConn_Lock(nc);
 
@@ -64,6 +239,22 @@ natsConn_publish(natsConnection *nc, const char *subj,
         return nats_setDefaultError(NATS_CONNECTION_CLOSED);
     }
 
+    // Apply the outbound limit, if any. This may release the lock
+    // while waiting for room, which is also done without a limit when
+    // the flusher thread is used (see natsConn_reserveOutbound()).
+    if ((nc->opts->maxOutboundBytes > 0) || (nc->bwBack != NULL))
+    {
+        bool drop = false;
+
+        s = natsConn_reserveOutbound(nc, msgHdSize + dataLen + _CRLF_LEN_, &drop);
+        if ((s != NATS_OK) || drop)
+        {
+            natsConn_Unlock(nc);
+
+            return NATS_UPDATE_ERR_STACK(s);
+        }
+    }
+
     if (natsConn_isDrainingPubs(nc))
     {
         natsConn_Unlock(nc);
@@ -85,80 +276,74 @@ natsConn_publish(natsConnection *nc, const char *subj,
     if ((reconnecting = natsConn_isReconnecting(nc)))
     {
         // Check if we are over
-        if (natsBuf_Len(nc->pending) >= nc->opts->reconnectBufSize)
+        if (natsSegBuf_Len(nc->pending) >= nc->opts->reconnectBufSize)
         {
             natsConn_Unlock(nc);
             return nats_setDefaultError(NATS_INSUFFICIENT_BUFFER);
         }
     }
 
-    if (dataLen > 0)
-    {
-        int l;
+    // Messages previously staged by this thread need to be sent first.
+    s = natsConn_drainPubStages(nc);
 
-        for (l = dataLen; l > 0; l /= 10)
-        {
-            i -= 1;
-            b[i] = digits[l%10];
-        }
+    if (pub != NULL)
+    {
+        // The header buffer is owned by the publisher, but since we
+        // update it under the connection lock, this is safe.
+        hdr = pub->hdr;
+        memcpy(hdr + pub->prefixLen, (b+i), sizeSize);
+        memcpy(hdr + pub->prefixLen + sizeSize, _CRLF_, _CRLF_LEN_);
     }
     else
     {
-        i -= 1;
-        b[i] = digits[0];
-    }
-
-    sizeSize = (bSize - i);
+        natsBuf_MoveTo(nc->scratch, _PUB_P_LEN_);
 
-    msgHdSize = _PUB_P_LEN_
-                + subjLen + 1
-                + (replyLen > 0 ? replyLen + 1 : 0)
-                + sizeSize + _CRLF_LEN_;
-
-    natsBuf_MoveTo(nc->scratch, _PUB_P_LEN_);
-
-    if (natsBuf_Capacity(nc->scratch) < msgHdSize)
-    {
-        // Although natsBuf_Append() would make sure that the buffer
-        // grows, it is better to make sure that the buffer is big
-        // enough for the pre-calculated size. We make it even a bit bigger.
-        s = natsBuf_Expand(nc->scratch, (int) ((float)msgHdSize * 1.1));
-    }
+        if (natsBuf_Capacity(nc->scratch) < msgHdSize)
+        {
+            // Although natsBuf_Append() would make sure that the buffer
+            // grows, it is better to make sure that the buffer is big
+            // enough for the pre-calculated size. We make it even a bit bigger.
+            s = natsBuf_Expand(nc->scratch, (int) ((float)msgHdSize * 1.1));
+        }
 
-    if (s == NATS_OK)
-        s = natsBuf_Append(nc->scratch, subj, subjLen);
-    if (s == NATS_OK)
-        s = natsBuf_Append(nc->scratch, _SPC_, _SPC_LEN_);
-    if ((s == NATS_OK) && (reply != NULL))
-    {
-        s = natsBuf_Append(nc->scratch, reply, replyLen);
+        if (s == NATS_OK)
+            s = natsBuf_Append(nc->scratch, subj, subjLen);
         if (s == NATS_OK)
             s = natsBuf_Append(nc->scratch, _SPC_, _SPC_LEN_);
+        if ((s == NATS_OK) && (reply != NULL))
+        {
+            s = natsBuf_Append(nc->scratch, reply, replyLen);
+            if (s == NATS_OK)
+                s = natsBuf_Append(nc->scratch, _SPC_, _SPC_LEN_);
+        }
+        if (s == NATS_OK)
+            s = natsBuf_Append(nc->scratch, (b+i), sizeSize);
+        if (s == NATS_OK)
+            s = natsBuf_Append(nc->scratch, _CRLF_, _CRLF_LEN_);
+
+        hdr = natsBuf_Data(nc->scratch);
     }
-    if (s == NATS_OK)
-        s = natsBuf_Append(nc->scratch, (b+i), sizeSize);
-    if (s == NATS_OK)
-        s = natsBuf_Append(nc->scratch, _CRLF_, _CRLF_LEN_);
 
     if (s == NATS_OK)
     {
-        int pos = 0;
+        int64_t pos = 0;
 
         if (reconnecting)
-            pos = natsBuf_Len(nc->pending);
+            pos = natsSegBuf_Len(nc->pending);
         else
             SET_WRITE_DEADLINE(nc);
 
-        s = natsConn_bufferWrite(nc, natsBuf_Data(nc->scratch), msgHdSize);
+        s = natsConn_bufferWrite(nc, hdr, msgHdSize);
 
-        if (s == NATS_OK)
-            s = natsConn_bufferWrite(nc, data, dataLen);
+        for (j=0; (s == NATS_OK) && (j<iovcnt); j++)
+            s = natsConn_bufferWrite(nc, (const char*) iov[j].iov_base,
+                                     (int) iov[j].iov_len);
 
         if (s == NATS_OK)
             s = natsConn_bufferWrite(nc, _CRLF_, _CRLF_LEN_);
 
         if ((s != NATS_OK) && reconnecting)
-            natsBuf_MoveTo(nc->pending, pos);
+            natsSegBuf_Truncate(nc->pending, pos);
     }
 
     if ((s == NATS_OK) && !reconnecting)
@@ -173,6 +358,8 @@ natsConn_publish(natsConnection *nc, const char *subj,
     {
         nc->stats.outMsgs  += 1;
         nc->stats.outBytes += dataLen;
+
+        natsConn_outboundChanged(nc);
     }
 
     natsConn_Unlock(nc);
@@ -180,6 +367,22 @@ natsConn_publish(natsConnection *nc, const char *subj,
     return NATS_UPDATE_ERR_STACK(s);
 }
 
+natsStatus
+natsConn_publish(natsConnection *nc, const char *subj,
+         const char *reply, const void *data, int dataLen,
+         bool directFlush)
+{
+    natsStatus      s;
+    natsIOVec       iov;
+
+    iov.iov_base = (void*) data;
+    iov.iov_len  = (size_t) (dataLen > 0 ? dataLen : 0);
+
+    s = _publishV(nc, subj, reply, NULL, &iov, 1, dataLen, directFlush);
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
 /*
  * Publishes the data argument to the given subject. The data argument is left
  * untouched and needs to be correctly interpreted on the receiver.
@@ -265,6 +468,398 @@ natsConnection_PublishRequestString(natsConnection *nc, const char *subj,
     return NATS_UPDATE_ERR_STACK(s);
 }
 
+/*
+ * Publishes the data, made of the concatenation of the given segments, to the
+ * given subject. Segments that do not fit in the outbound buffer are sent
+ * from the user memory, without being copied.
+ */
+natsStatus
+natsConnection_PublishV(natsConnection *nc, const char *subj,
+                        const char *reply, const natsIOVec *iov,
+                        int iovcnt)
+{
+    natsStatus  s;
+    int64_t     dataLen = 0;
+    int         i;
+
+    if ((iovcnt < 0) || ((iov == NULL) && (iovcnt > 0)))
+        return nats_setDefaultError(NATS_INVALID_ARG);
+
+    for (i=0; i<iovcnt; i++)
+    {
+        if ((iov[i].iov_base == NULL) && (iov[i].iov_len > 0))
+            return nats_setDefaultError(NATS_INVALID_ARG);
+
+        dataLen += (int64_t) iov[i].iov_len;
+    }
+    if (dataLen > INT32_MAX)
+        return nats_setError(NATS_INVALID_ARG,
+                             "Total size of segments too big: %" PRId64,
+                             dataLen);
+
+    s = _publishV(nc, subj, reply, NULL, iov, iovcnt, (int) dataLen, false);
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
+/*
+ * Creates a publisher that pre-encodes the "PUB <subject> [<reply> ]"
+ * protocol prefix.
+ */
+natsStatus
+natsPublisher_Create(natsPublisher **newPub, natsConnection *nc,
+                     const char *subj, const char *reply)
+{
+    natsPublisher   *pub     = NULL;
+    int             subjLen  = 0;
+    int             replyLen = 0;
+    char            *ptr     = NULL;
+
+    if ((newPub == NULL) || (nc == NULL))
+        return nats_setDefaultError(NATS_INVALID_ARG);
+
+    if ((subj == NULL) || ((subjLen = (int) strlen(subj)) == 0))
+        return nats_setDefaultError(NATS_INVALID_SUBJECT);
+
+    replyLen = ((reply != NULL) ? (int) strlen(reply) : 0);
+
+    pub = (natsPublisher*) NATS_CALLOC(1, sizeof(natsPublisher));
+    if (pub == NULL)
+        return nats_setDefaultError(NATS_NO_MEMORY);
+
+    pub->prefixLen = _PUB_P_LEN_
+                     + subjLen + 1
+                     + (replyLen > 0 ? replyLen + 1 : 0);
+
+    // Add room for the payload size (up to 10 digits) and CRLF.
+    pub->hdr = (char*) NATS_MALLOC(pub->prefixLen + 10 + _CRLF_LEN_);
+    if (pub->hdr == NULL)
+    {
+        NATS_FREE(pub);
+        return nats_setDefaultError(NATS_NO_MEMORY);
+    }
+
+    ptr = pub->hdr;
+    memcpy(ptr, _PUB_P_, _PUB_P_LEN_);
+    ptr += _PUB_P_LEN_;
+    memcpy(ptr, subj, subjLen);
+    ptr += subjLen;
+    *(ptr++) = ' ';
+    if (replyLen > 0)
+    {
+        memcpy(ptr, reply, replyLen);
+        ptr += replyLen;
+        *(ptr++) = ' ';
+    }
+
+    natsConn_retain(nc);
+    pub->nc = nc;
+
+    *newPub = pub;
+
+    return NATS_OK;
+}
+
+/*
+ * Publishes the data argument to the publisher's subject.
+ */
+natsStatus
+natsPublisher_Publish(natsPublisher *pub, const void *data, int dataLen)
+{
+    natsStatus      s;
+    natsIOVec       iov;
+
+    if (pub == NULL)
+        return nats_setDefaultError(NATS_INVALID_ARG);
+
+    iov.iov_base = (void*) data;
+    iov.iov_len  = (size_t) (dataLen > 0 ? dataLen : 0);
+
+    s = _publishV(pub->nc, NULL, NULL, pub, &iov, 1, dataLen, false);
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
+/*
+ * Destroys the publisher and releases the connection.
+ */
+void
+natsPublisher_Destroy(natsPublisher *pub)
+{
+    if (pub == NULL)
+        return;
+
+    natsConn_release(pub->nc);
+
+    NATS_FREE(pub->hdr);
+    NATS_FREE(pub);
+}
+
+// Formats the PUB protocol line directly into the write buffer. If there
+// is not enough room, the write buffer is flushed first, or expanded.
+// When reconnecting, the protocol line is appended to the pending buffer.
+// Connection lock is held on entry.
+static natsStatus
+_writePubHeader(natsConnection *nc, const char *subj, int subjLen,
+                const char *reply, int replyLen, int dataLen)
+{
+    natsStatus  s       = NATS_OK;
+    natsBuffer  *buf    = nc->bw;
+    char        b[12];
+    int         bSize   = sizeof(b);
+    int         i       = bSize;
+    int         sizeSize= 0;
+    int         hdrSize = 0;
+    char        *ptr    = NULL;
+
+    if (dataLen > 0)
+    {
+        int l;
+
+        for (l = dataLen; l > 0; l /= 10)
+        {
+            i -= 1;
+            b[i] = digits[l%10];
+        }
+    }
+    else
+    {
+        i -= 1;
+        b[i] = digits[0];
+    }
+
+    sizeSize = (bSize - i);
+
+    if (nc->usePending)
+    {
+        s = natsSegBuf_Append(nc->pending, _PUB_P_, _PUB_P_LEN_);
+        if (s == NATS_OK)
+            s = natsSegBuf_Append(nc->pending, subj, subjLen);
+        if (s == NATS_OK)
+            s = natsSegBuf_Append(nc->pending, _SPC_, _SPC_LEN_);
+        if ((s == NATS_OK) && (replyLen > 0))
+        {
+            s = natsSegBuf_Append(nc->pending, reply, replyLen);
+            if (s == NATS_OK)
+                s = natsSegBuf_Append(nc->pending, _SPC_, _SPC_LEN_);
+        }
+        if (s == NATS_OK)
+            s = natsSegBuf_Append(nc->pending, (b+i), sizeSize);
+        if (s == NATS_OK)
+            s = natsSegBuf_Append(nc->pending, _CRLF_, _CRLF_LEN_);
+
+        return NATS_UPDATE_ERR_STACK(s);
+    }
+
+    hdrSize = _PUB_P_LEN_
+              + subjLen + 1
+              + (replyLen > 0 ? replyLen + 1 : 0)
+              + sizeSize + _CRLF_LEN_;
+
+    if (natsBuf_Available(buf) < hdrSize)
+    {
+        // When writing to the socket, try to make room by flushing first.
+        if (!(nc->sockCtx.useEventLoop)
+            && (natsBuf_Len(buf) > 0))
+        {
+            s = natsConn_bufferFlush(nc);
+        }
+        if ((s == NATS_OK) && (natsBuf_Available(buf) < hdrSize))
+            s = natsBuf_Expand(buf, natsBuf_Len(buf) + hdrSize);
+    }
+    if (s != NATS_OK)
+        return NATS_UPDATE_ERR_STACK(s);
+
+    ptr = natsBuf_Data(buf) + natsBuf_Len(buf);
+
+    memcpy(ptr, _PUB_P_, _PUB_P_LEN_);
+    ptr += _PUB_P_LEN_;
+    memcpy(ptr, subj, subjLen);
+    ptr += subjLen;
+    *(ptr++) = ' ';
+    if (replyLen > 0)
+    {
+        memcpy(ptr, reply, replyLen);
+        ptr += replyLen;
+        *(ptr++) = ' ';
+    }
+    memcpy(ptr, (b+i), sizeSize);
+    ptr += sizeSize;
+    memcpy(ptr, _CRLF_, _CRLF_LEN_);
+
+    natsBuf_MoveTo(buf, natsBuf_Len(buf) + hdrSize);
+
+    return NATS_OK;
+}
+
+/*
+ * Publishes all items of the array under a single acquisition of the
+ * connection lock, and kicks the flusher (or flushes) only once.
+ */
+natsStatus
+natsConnection_PublishBatch(natsConnection *nc, const natsPubItem *items,
+                            int count, natsStatus *itemsStatus)
+{
+    natsStatus          s           = NATS_OK;
+    natsStatus          ret         = NATS_OK;
+    const natsPubItem   *item       = NULL;
+    bool                reconnecting= false;
+    int                 sent        = 0;
+    int                 i;
+
+    if ((nc == NULL) || (items == NULL) || (count <= 0))
+        return nats_setDefaultError(NATS_INVALID_ARG);
+
+    for (i=0; i<count; i++)
+    {
+        item = &(items[i]);
+
+        if ((item->subject == NULL) || (item->subject[0] == '\0'))
+            return nats_setDefaultError(NATS_INVALID_SUBJECT);
+
+        if ((item->dataLen < 0) || ((item->data == NULL) && (item->dataLen > 0)))
+            return nats_setDefaultError(NATS_INVALID_ARG);
+    }
+
+    natsConn_Lock(nc);
+
+    if (natsConn_isClosed(nc))
+    {
+        natsConn_Unlock(nc);
+
+        return nats_setDefaultError(NATS_CONNECTION_CLOSED);
+    }
+
+    if (natsConn_isDrainingPubs(nc))
+    {
+        natsConn_Unlock(nc);
+
+        return nats_setDefaultError(NATS_DRAINING);
+    }
+
+    if (!(reconnecting = natsConn_isReconnecting(nc)))
+        SET_WRITE_DEADLINE(nc);
+
+    // Messages staged by this thread need to be sent before the batch.
+    s = natsConn_drainPubStages(nc);
+    if (s != NATS_OK)
+    {
+        natsConn_Unlock(nc);
+
+        return NATS_UPDATE_ERR_STACK(s);
+    }
+
+    for (i=0; i<count; i++)
+    {
+        int64_t pos  = 0;
+        int subjLen  = 0;
+        int replyLen = 0;
+
+        item = &(items[i]);
+
+        subjLen  = (int) strlen(item->subject);
+        replyLen = (item->reply != NULL ? (int) strlen(item->reply) : 0);
+
+        // Apply the outbound limit, if any. The size of the protocol
+        // line is estimated using the maximum number of size digits.
+        if ((nc->opts->maxOutboundBytes > 0) || (nc->bwBack != NULL))
+        {
+            bool drop = false;
+
+            s = natsConn_reserveOutbound(nc,
+                                         _PUB_P_LEN_ + subjLen + 1 + replyLen + 1 + 10
+                                         + _CRLF_LEN_ + item->dataLen + _CRLF_LEN_,
+                                         &drop);
+            if (s != NATS_OK)
+                break;
+
+            if (drop)
+            {
+                if (itemsStatus != NULL)
+                    itemsStatus[i] = NATS_OK;
+                continue;
+            }
+
+            // The lock may have been released, so the state may have changed.
+            if (reconnecting != natsConn_isReconnecting(nc))
+            {
+                if ((sent > 0) && !reconnecting)
+                    natsConn_flushOrKickFlusher(nc);
+
+                if (!(reconnecting = natsConn_isReconnecting(nc)))
+                    SET_WRITE_DEADLINE(nc);
+            }
+        }
+
+        if (!nc->initc && ((int64_t) item->dataLen > nc->info.maxPayload))
+        {
+            if (itemsStatus != NULL)
+                itemsStatus[i] = NATS_MAX_PAYLOAD;
+
+            if (ret == NATS_OK)
+                ret = nats_setError(NATS_MAX_PAYLOAD,
+                                    "Payload %d of item %d greater than maximum allowed: %" PRId64,
+                                    item->dataLen, i, nc->info.maxPayload);
+            continue;
+        }
+
+        if (reconnecting)
+        {
+            if (natsSegBuf_Len(nc->pending) >= nc->opts->reconnectBufSize)
+            {
+                s = nats_setDefaultError(NATS_INSUFFICIENT_BUFFER);
+                break;
+            }
+            pos = natsSegBuf_Len(nc->pending);
+        }
+
+        s = _writePubHeader(nc, item->subject, subjLen,
+                            item->reply, replyLen, item->dataLen);
+        if (s == NATS_OK)
+            s = natsConn_bufferWrite(nc, (const char*) item->data, item->dataLen);
+        if (s == NATS_OK)
+            s = natsConn_bufferWrite(nc, _CRLF_, _CRLF_LEN_);
+
+        if (s != NATS_OK)
+        {
+            if (reconnecting)
+                natsSegBuf_Truncate(nc->pending, pos);
+            break;
+        }
+
+        if (itemsStatus != NULL)
+            itemsStatus[i] = NATS_OK;
+
+        nc->stats.outMsgs  += 1;
+        nc->stats.outBytes += item->dataLen;
+        sent++;
+    }
+
+    // Items that could not be sent get the error that stopped the batch.
+    if (s != NATS_OK)
+    {
+        if (ret == NATS_OK)
+            ret = s;
+
+        for (; (itemsStatus != NULL) && (i<count); i++)
+            itemsStatus[i] = s;
+    }
+
+    if ((sent > 0) && !reconnecting)
+    {
+        s = natsConn_flushOrKickFlusher(nc);
+        if ((s != NATS_OK) && (ret == NATS_OK))
+            ret = s;
+    }
+
+    if (sent > 0)
+        natsConn_outboundChanged(nc);
+
+    natsConn_Unlock(nc);
+
+    return NATS_UPDATE_ERR_STACK(ret);
+}
+
 // Old way of sending a request...
 static natsStatus
 _oldRequest(natsMsg **replyMsg, natsConnection *nc, const char *subj,
@@ -336,6 +931,10 @@ natsConnection_Request(natsMsg **replyMsg, natsConnection *nc, const char *subj,
     if ((replyMsg == NULL) || (nc == NULL))
         return nats_setDefaultError(NATS_INVALID_ARG);
 
+    // The reply would be read by the thread waiting for it.
+    if (nats_isInlineDeliveryConn(nc))
+        return nats_setError(NATS_ILLEGAL_STATE, "%s", INLINE_DLV_BLOCKING_ERR);
+
     natsConn_Lock(nc);
     if (natsConn_isClosed(nc))
     {
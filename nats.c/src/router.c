@@ -0,0 +1,650 @@
+// Copyright 2020 The NATS Authors
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "natsp.h"
+
+#include <string.h>
+
+#include "mem.h"
+#include "conn.h"
+#include "sub.h"
+#include "router.h"
+
+static void
+_freeNode(natsRouterNode *node);
+
+static void
+_releaseHandler(natsRouterHandler *h)
+{
+    if (--(h->refs) == 0)
+        NATS_FREE(h);
+}
+
+static void
+_freeNodeContent(natsRouterNode *node)
+{
+    natsStrHashIter     iter;
+    natsRouterNode      *child = NULL;
+    natsRouterHandler   *h     = NULL;
+
+    while ((h = node->handlers) != NULL)
+    {
+        node->handlers = h->next;
+        h->removed = true;
+        _releaseHandler(h);
+    }
+    if (node->literals != NULL)
+    {
+        natsStrHashIter_Init(&iter, node->literals);
+        while (natsStrHashIter_Next(&iter, NULL, (void**) &child))
+            _freeNode(child);
+        natsStrHashIter_Done(&iter);
+
+        natsStrHash_Destroy(node->literals);
+    }
+    _freeNode(node->pwc);
+    _freeNode(node->fwc);
+
+    NATS_FREE(node->token);
+}
+
+static void
+_freeNode(natsRouterNode *node)
+{
+    if (node == NULL)
+        return;
+
+    _freeNodeContent(node);
+    NATS_FREE(node);
+}
+
+static void
+_freeMatch(natsRouterMatch *m)
+{
+    if (m == NULL)
+        return;
+
+    NATS_FREE(m->handlers);
+    NATS_FREE(m);
+}
+
+static void
+_freeRouter(natsRouter *r)
+{
+    natsStrHashIter     iter;
+    natsRouterMatch     *m = NULL;
+
+    _freeNodeContent(&(r->root));
+
+    if (r->cache != NULL)
+    {
+        natsStrHashIter_Init(&iter, r->cache);
+        while (natsStrHashIter_Next(&iter, NULL, (void**) &m))
+            _freeMatch(m);
+        natsStrHashIter_Done(&iter);
+
+        natsStrHash_Destroy(r->cache);
+    }
+    natsHash_Destroy(r->handlers);
+
+    NATS_FREE(r->subjBuf);
+    NATS_FREE(r->tokens);
+    NATS_FREE(r->dispatch);
+
+    natsMutex_Destroy(r->mu);
+    natsConn_release(r->nc);
+
+    NATS_FREE(r);
+}
+
+static void
+_retainRouter(natsRouter *r)
+{
+    natsMutex_Lock(r->mu);
+    r->refs++;
+    natsMutex_Unlock(r->mu);
+}
+
+static void
+_releaseRouter(natsRouter *r)
+{
+    int refs;
+
+    natsMutex_Lock(r->mu);
+    refs = --(r->refs);
+    natsMutex_Unlock(r->mu);
+
+    if (refs == 0)
+        _freeRouter(r);
+}
+
+// Splits 'subj' in place (dots are replaced with '\0') and stores the
+// start of each token in the router's tokens array, which is expanded if
+// needed. If 'isFilter' is true, the subject is validated: tokens can't be
+// empty and '>' can only be the last token.
+static natsStatus
+_tokenize(natsRouter *r, char *subj, int *count, bool isFilter)
+{
+    char    *p  = subj;
+    char    **newTokens;
+    int     n   = 0;
+    int     i;
+
+    while (true)
+    {
+        if (n == r->tokensCap)
+        {
+            newTokens = (char**) NATS_REALLOC(r->tokens,
+                                              (r->tokensCap + 16) * sizeof(char*));
+            if (newTokens == NULL)
+                return nats_setDefaultError(NATS_NO_MEMORY);
+
+            r->tokens     = newTokens;
+            r->tokensCap += 16;
+        }
+
+        r->tokens[n++] = p;
+
+        p = strchr(p, '.');
+        if (p == NULL)
+            break;
+
+        *(p++) = '\0';
+    }
+
+    if (isFilter)
+    {
+        for (i=0; i<n; i++)
+        {
+            if ((r->tokens[i][0] == '\0')
+                || ((i < n - 1) && (strcmp(r->tokens[i], ">") == 0)))
+            {
+                return nats_setDefaultError(NATS_INVALID_SUBJECT);
+            }
+        }
+    }
+
+    *count = n;
+
+    return NATS_OK;
+}
+
+static natsStatus
+_getOrCreateChild(natsRouterNode *node, char *token, natsRouterNode **child)
+{
+    natsStatus      s       = NATS_OK;
+    natsRouterNode  *c      = NULL;
+    bool            isPwc   = (strcmp(token, "*") == 0);
+    bool            isFwc   = (strcmp(token, ">") == 0);
+
+    if (isPwc)
+        c = node->pwc;
+    else if (isFwc)
+        c = node->fwc;
+    else if (node->literals != NULL)
+        c = (natsRouterNode*) natsStrHash_Get(node->literals, token);
+
+    if (c != NULL)
+    {
+        *child = c;
+        return NATS_OK;
+    }
+
+    c = (natsRouterNode*) NATS_CALLOC(1, sizeof(natsRouterNode));
+    if (c == NULL)
+        return nats_setDefaultError(NATS_NO_MEMORY);
+
+    c->parent = node;
+
+    if (isPwc)
+    {
+        node->pwc = c;
+    }
+    else if (isFwc)
+    {
+        node->fwc = c;
+    }
+    else
+    {
+        if (node->literals == NULL)
+            s = natsStrHash_Create(&(node->literals), 4);
+        if (s == NATS_OK)
+        {
+            c->token = NATS_STRDUP(token);
+            if (c->token == NULL)
+                s = nats_setDefaultError(NATS_NO_MEMORY);
+        }
+        if (s == NATS_OK)
+            s = natsStrHash_Set(node->literals, c->token, false, (void*) c, NULL);
+        if (s != NATS_OK)
+        {
+            NATS_FREE(c->token);
+            NATS_FREE(c);
+            return NATS_UPDATE_ERR_STACK(s);
+        }
+    }
+
+    *child = c;
+
+    return NATS_OK;
+}
+
+// Removes nodes that no longer have handlers nor children, starting with
+// 'node' and going up to the root.
+static void
+_pruneNodes(natsRouter *r, natsRouterNode *node)
+{
+    natsRouterNode *parent;
+
+    while ((node != &(r->root))
+           && (node->handlers == NULL)
+           && (node->pwc == NULL)
+           && (node->fwc == NULL)
+           && ((node->literals == NULL) || (natsStrHash_Count(node->literals) == 0)))
+    {
+        parent = node->parent;
+
+        if (parent->pwc == node)
+            parent->pwc = NULL;
+        else if (parent->fwc == node)
+            parent->fwc = NULL;
+        else
+            (void) natsStrHash_Remove(parent->literals, node->token);
+
+        _freeNode(node);
+
+        node = parent;
+    }
+}
+
+static natsStatus
+_addToMatch(natsRouterMatch *m, natsRouterHandler *h)
+{
+    natsRouterHandler **newHandlers;
+
+    for (; h != NULL; h = h->next)
+    {
+        if (m->count == m->cap)
+        {
+            newHandlers = (natsRouterHandler**) NATS_REALLOC(m->handlers,
+                                    (m->cap + 8) * sizeof(natsRouterHandler*));
+            if (newHandlers == NULL)
+                return nats_setDefaultError(NATS_NO_MEMORY);
+
+            m->handlers = newHandlers;
+            m->cap     += 8;
+        }
+        m->handlers[m->count++] = h;
+    }
+
+    return NATS_OK;
+}
+
+// Collects the handlers of all nodes matching the tokens, starting at
+// index 'i'. At each level, only the literal child and the '*' child need
+// to be followed, and the '>' child matches all remaining tokens.
+static natsStatus
+_match(natsRouterNode *node, char **tokens, int count, int i, natsRouterMatch *m)
+{
+    natsStatus      s       = NATS_OK;
+    natsRouterNode  *child  = NULL;
+
+    if ((node->fwc != NULL) && (i < count))
+        s = _addToMatch(m, node->fwc->handlers);
+
+    if ((s == NATS_OK) && (i == count))
+        return _addToMatch(m, node->handlers);
+
+    if ((s == NATS_OK) && (node->literals != NULL))
+    {
+        child = (natsRouterNode*) natsStrHash_Get(node->literals, tokens[i]);
+        if (child != NULL)
+            s = _match(child, tokens, count, i+1, m);
+    }
+    if ((s == NATS_OK) && (node->pwc != NULL))
+        s = _match(node->pwc, tokens, count, i+1, m);
+
+    return s;
+}
+
+static void
+_evictFromCache(natsRouter *r)
+{
+    natsStrHashIter     iter;
+    natsRouterMatch     *m = NULL;
+    int                 n  = natsStrHash_Count(r->cache) / 4;
+
+    natsStrHashIter_Init(&iter, r->cache);
+    while ((n-- > 0) && natsStrHashIter_Next(&iter, NULL, (void**) &m))
+    {
+        (void) natsStrHashIter_RemoveCurrent(&iter);
+        _freeMatch(m);
+    }
+    natsStrHashIter_Done(&iter);
+}
+
+// Returns the handlers matching this subject, from the cache if they have
+// been computed since the last change to the trie. Router's lock is held.
+static natsStatus
+_getMatch(natsRouter *r, const char *subject, natsRouterMatch **match)
+{
+    natsStatus      s       = NATS_OK;
+    natsRouterMatch *m      = NULL;
+    int             subjLen = 0;
+    int             count   = 0;
+    char            *newBuf = NULL;
+    bool            isNew   = false;
+
+    m = (natsRouterMatch*) natsStrHash_Get(r->cache, (char*) subject);
+    if ((m != NULL) && (m->gen == r->gen))
+    {
+        *match = m;
+        return NATS_OK;
+    }
+
+    if (m == NULL)
+    {
+        m = (natsRouterMatch*) NATS_CALLOC(1, sizeof(natsRouterMatch));
+        if (m == NULL)
+            return nats_setDefaultError(NATS_NO_MEMORY);
+
+        isNew = true;
+    }
+    m->count = 0;
+
+    // Tokenize a copy of the subject.
+    subjLen = (int) strlen(subject);
+    if (subjLen + 1 > r->subjBufCap)
+    {
+        newBuf = (char*) NATS_REALLOC(r->subjBuf, subjLen + 1);
+        if (newBuf == NULL)
+            s = nats_setDefaultError(NATS_NO_MEMORY);
+        else
+        {
+            r->subjBuf    = newBuf;
+            r->subjBufCap = subjLen + 1;
+        }
+    }
+    if (s == NATS_OK)
+    {
+        memcpy(r->subjBuf, subject, subjLen + 1);
+        s = _tokenize(r, r->subjBuf, &count, false);
+    }
+    if (s == NATS_OK)
+        s = _match(&(r->root), r->tokens, count, 0, m);
+    if ((s == NATS_OK) && isNew)
+    {
+        if (natsStrHash_Count(r->cache) >= NATS_ROUTER_CACHE_MAX_SIZE)
+            _evictFromCache(r);
+
+        s = natsStrHash_Set(r->cache, (char*) subject, true, (void*) m, NULL);
+    }
+    if (s == NATS_OK)
+    {
+        m->gen = r->gen;
+        *match = m;
+    }
+    else if (isNew)
+    {
+        _freeMatch(m);
+    }
+    else
+    {
+        // Make sure this stale entry is not used.
+        m->gen = -1;
+    }
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
+// Subscription's callback. Invokes all handlers matching the message's
+// subject, and then destroys the message.
+static void
+_routeMsg(natsConnection *nc, natsSubscription *sub, natsMsg *msg, void *closure)
+{
+    natsRouter          *r      = (natsRouter*) closure;
+    natsRouterMatch     *m      = NULL;
+    natsRouterHandler   **newDispatch;
+    natsStatus          s;
+    int                 count   = 0;
+    int                 i;
+
+    natsMutex_Lock(r->mu);
+
+    s = _getMatch(r, natsMsg_GetSubject(msg), &m);
+    if ((s == NATS_OK) && (m->count > r->dispatchCap))
+    {
+        newDispatch = (natsRouterHandler**) NATS_REALLOC(r->dispatch,
+                                    m->count * sizeof(natsRouterHandler*));
+        if (newDispatch == NULL)
+            s = nats_setDefaultError(NATS_NO_MEMORY);
+        else
+        {
+            r->dispatch    = newDispatch;
+            r->dispatchCap = m->count;
+        }
+    }
+    if (s == NATS_OK)
+    {
+        // The message is delivered by a single thread, so the dispatch
+        // array can be reused. Handlers are retained since they may be
+        // removed while the lock is released.
+        count = m->count;
+        for (i=0; i<count; i++)
+        {
+            r->dispatch[i] = m->handlers[i];
+            r->dispatch[i]->refs++;
+        }
+    }
+
+    natsMutex_Unlock(r->mu);
+
+    for (i=0; i<count; i++)
+    {
+        if (!(r->dispatch[i]->removed))
+            (*(r->dispatch[i]->cb))(nc, r, msg, r->dispatch[i]->closure);
+    }
+
+    if (count > 0)
+    {
+        natsMutex_Lock(r->mu);
+        for (i=0; i<count; i++)
+            _releaseHandler(r->dispatch[i]);
+        natsMutex_Unlock(r->mu);
+    }
+
+    natsMsg_Destroy(msg);
+}
+
+// Invoked when the subscription is closed and no more message will be
+// delivered.
+static void
+_routerSubComplete(void *closure)
+{
+    _releaseRouter((natsRouter*) closure);
+}
+
+natsStatus
+natsRouter_Create(natsRouter **newRouter, natsConnection *nc, const char *subject)
+{
+    natsStatus  s = NATS_OK;
+    natsRouter  *r = NULL;
+
+    if ((newRouter == NULL) || (nc == NULL))
+        return nats_setDefaultError(NATS_INVALID_ARG);
+
+    if ((subject == NULL) || (subject[0] == '\0'))
+        return nats_setDefaultError(NATS_INVALID_SUBJECT);
+
+    r = (natsRouter*) NATS_CALLOC(1, sizeof(natsRouter));
+    if (r == NULL)
+        return nats_setDefaultError(NATS_NO_MEMORY);
+
+    r->refs = 1;
+
+    natsConn_retain(nc);
+    r->nc = nc;
+
+    s = natsMutex_Create(&(r->mu));
+    if (s == NATS_OK)
+        s = natsHash_Create(&(r->handlers), 16);
+    if (s == NATS_OK)
+        s = natsStrHash_Create(&(r->cache), 64);
+    if (s == NATS_OK)
+    {
+        // The subscription's callback uses the router, so it keeps a
+        // reference until it is complete. The completion callback is set
+        // when the subscription is created, so it is invoked whenever the
+        // subscription is returned.
+        r->refs++;
+
+        s = natsConn_subscribeWithCompleteCB(&(r->sub), nc, subject,
+                                             _routeMsg, (void*) r,
+                                             _routerSubComplete, (void*) r);
+        if (s != NATS_OK)
+            r->refs--;
+    }
+
+    if (s == NATS_OK)
+        *newRouter = r;
+    else
+        _freeRouter(r);
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
+natsStatus
+natsRouter_AddHandler(int64_t *handlerId, natsRouter *router,
+                      const char *subject, natsRouteHandler cb, void *closure)
+{
+    natsStatus          s       = NATS_OK;
+    natsRouterNode      *node   = NULL;
+    natsRouterHandler   *h      = NULL;
+    char                *subj   = NULL;
+    int64_t             id      = 0;
+    int                 count   = 0;
+    int                 i;
+
+    if ((router == NULL) || (cb == NULL))
+        return nats_setDefaultError(NATS_INVALID_ARG);
+
+    if ((subject == NULL) || (subject[0] == '\0'))
+        return nats_setDefaultError(NATS_INVALID_SUBJECT);
+
+    subj = NATS_STRDUP(subject);
+    h    = (natsRouterHandler*) NATS_CALLOC(1, sizeof(natsRouterHandler));
+    if ((subj == NULL) || (h == NULL))
+    {
+        NATS_FREE(subj);
+        NATS_FREE(h);
+        return nats_setDefaultError(NATS_NO_MEMORY);
+    }
+
+    natsMutex_Lock(router->mu);
+
+    node = &(router->root);
+
+    s = _tokenize(router, subj, &count, true);
+    for (i=0; (s == NATS_OK) && (i<count); i++)
+        s = _getOrCreateChild(node, router->tokens[i], &node);
+    if (s == NATS_OK)
+    {
+        h->id      = ++(router->nextId);
+        h->cb      = cb;
+        h->closure = closure;
+        h->refs    = 1;
+        h->node    = node;
+
+        id = h->id;
+
+        s = natsHash_Set(router->handlers, h->id, (void*) h, NULL);
+    }
+    if (s == NATS_OK)
+    {
+        h->next = node->handlers;
+        if (node->handlers != NULL)
+            node->handlers->prev = h;
+        node->handlers = h;
+
+        // Invalidates the cached matches.
+        router->gen++;
+    }
+    else
+    {
+        _pruneNodes(router, node);
+        NATS_FREE(h);
+    }
+
+    natsMutex_Unlock(router->mu);
+
+    NATS_FREE(subj);
+
+    if ((s == NATS_OK) && (handlerId != NULL))
+        *handlerId = id;
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
+natsStatus
+natsRouter_RemoveHandler(natsRouter *router, int64_t handlerId)
+{
+    natsRouterHandler   *h    = NULL;
+    natsRouterNode      *node = NULL;
+
+    if (router == NULL)
+        return nats_setDefaultError(NATS_INVALID_ARG);
+
+    natsMutex_Lock(router->mu);
+
+    h = (natsRouterHandler*) natsHash_Remove(router->handlers, handlerId);
+    if (h == NULL)
+    {
+        natsMutex_Unlock(router->mu);
+        return nats_setDefaultError(NATS_NOT_FOUND);
+    }
+
+    node = h->node;
+
+    if (h->prev != NULL)
+        h->prev->next = h->next;
+    else
+        node->handlers = h->next;
+    if (h->next != NULL)
+        h->next->prev = h->prev;
+
+    h->node    = NULL;
+    h->removed = true;
+
+    _pruneNodes(router, node);
+
+    router->gen++;
+
+    _releaseHandler(h);
+
+    natsMutex_Unlock(router->mu);
+
+    return NATS_OK;
+}
+
+void
+natsRouter_Destroy(natsRouter *router)
+{
+    if (router == NULL)
+        return;
+
+    // This closes the subscription, which then releases its reference
+    // once its callback is no longer invoked.
+    natsSubscription_Destroy(router->sub);
+
+    _releaseRouter(router);
+}
@@ -0,0 +1,102 @@
+// Copyright 2020 The NATS Authors
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROUTER_H_
+#define ROUTER_H_
+
+#include "natsp.h"
+
+// Maximum number of subjects for which the list of matching handlers is
+// cached. When reached, a quarter of the entries are evicted.
+#define NATS_ROUTER_CACHE_MAX_SIZE  (4096)
+
+struct __natsRouterNode;
+
+typedef struct __natsRouterHandler
+{
+    int64_t                     id;
+    natsRouteHandler            cb;
+    void                        *closure;
+
+    // The trie holds a reference, and so does natsRouter's dispatch
+    // while the callback is invoked.
+    int                         refs;
+    bool                        removed;
+
+    struct __natsRouterNode     *node;
+    struct __natsRouterHandler  *prev;
+    struct __natsRouterHandler  *next;
+
+} natsRouterHandler;
+
+// A node of the subject trie. Handlers are attached to the node at which
+// their subject ends. Children are indexed by literal token, and the '*'
+// and '>' wildcards have their own child.
+typedef struct __natsRouterNode
+{
+    struct __natsRouterNode     *parent;
+    // Key of this node in the parent's 'literals', NULL for wildcards.
+    char                        *token;
+
+    natsStrHash                 *literals;
+    struct __natsRouterNode     *pwc;
+    struct __natsRouterNode     *fwc;
+
+    natsRouterHandler           *handlers;
+
+} natsRouterNode;
+
+// Cached result of a match. It is valid only if 'gen' is the router's
+// current generation, which changes each time a handler is added or
+// removed.
+typedef struct __natsRouterMatch
+{
+    int64_t                     gen;
+    natsRouterHandler           **handlers;
+    int                         count;
+    int                         cap;
+
+} natsRouterMatch;
+
+struct __natsRouter
+{
+    natsMutex                   *mu;
+    int                         refs;
+
+    natsConnection              *nc;
+    natsSubscription            *sub;
+
+    natsRouterNode              root;
+
+    // Handlers by id.
+    natsHash                    *handlers;
+    int64_t                     nextId;
+
+    // Matching handlers by subject, so that the subject of messages does
+    // not need to be split and matched against the trie each time.
+    natsStrHash                 *cache;
+    int64_t                     gen;
+
+    // Used when matching a subject that is not in the cache.
+    char                        *subjBuf;
+    int                         subjBufCap;
+    char                        **tokens;
+    int                         tokensCap;
+
+    // Handlers invoked for the current message.
+    natsRouterHandler           **dispatch;
+    int                         dispatchCap;
+
+};
+
+#endif /* ROUTER_H_ */
@@ -0,0 +1,250 @@
+// Copyright 2020 The NATS Authors
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "natsp.h"
+
+#include <string.h>
+
+#include "mem.h"
+#include "segbuf.h"
+
+natsStatus
+natsSegBuf_Create(natsSegBuffer **newBuf, int chunkSize)
+{
+    natsSegBuffer *buf = NULL;
+
+    if (chunkSize <= 0)
+        return nats_setDefaultError(NATS_INVALID_ARG);
+
+    buf = (natsSegBuffer*) NATS_CALLOC(1, sizeof(natsSegBuffer));
+    if (buf == NULL)
+        return nats_setDefaultError(NATS_NO_MEMORY);
+
+    buf->chunkSize = chunkSize;
+
+    *newBuf = buf;
+
+    return NATS_OK;
+}
+
+static natsStatus
+_addChunk(natsSegBuffer *buf)
+{
+    natsSegChunk *chunk = buf->free;
+
+    if (chunk != NULL)
+    {
+        buf->free = chunk->next;
+        buf->freeCount--;
+    }
+    else
+    {
+        // The chunk structure and its data are allocated in one block.
+        chunk = (natsSegChunk*) NATS_MALLOC(sizeof(natsSegChunk) + buf->chunkSize);
+        if (chunk == NULL)
+            return nats_setDefaultError(NATS_NO_MEMORY);
+
+        chunk->data = (char*) (chunk + 1);
+    }
+
+    chunk->len  = 0;
+    chunk->next = NULL;
+
+    if (buf->tail != NULL)
+        buf->tail->next = chunk;
+    else
+        buf->head = chunk;
+
+    buf->tail = chunk;
+
+    return NATS_OK;
+}
+
+static void
+_releaseChunk(natsSegBuffer *buf, natsSegChunk *chunk)
+{
+    if (buf->freeCount < NATS_SEGBUF_MAX_FREE_CHUNKS)
+    {
+        chunk->next = buf->free;
+        buf->free   = chunk;
+        buf->freeCount++;
+    }
+    else
+    {
+        NATS_FREE(chunk);
+    }
+}
+
+static void
+_releaseChunks(natsSegBuffer *buf, natsSegChunk *chunk)
+{
+    natsSegChunk *next;
+
+    while (chunk != NULL)
+    {
+        next = chunk->next;
+        _releaseChunk(buf, chunk);
+        chunk = next;
+    }
+}
+
+natsStatus
+natsSegBuf_Append(natsSegBuffer *buf, const char *data, int dataLen)
+{
+    natsStatus  s = NATS_OK;
+    int         n;
+
+    while (dataLen > 0)
+    {
+        if ((buf->tail == NULL) || (buf->tail->len == buf->chunkSize))
+        {
+            s = _addChunk(buf);
+            if (s != NATS_OK)
+                return NATS_UPDATE_ERR_STACK(s);
+        }
+
+        n = buf->chunkSize - buf->tail->len;
+        if (n > dataLen)
+            n = dataLen;
+
+        memcpy(buf->tail->data + buf->tail->len, data, n);
+        buf->tail->len += n;
+        buf->len       += n;
+
+        data    += n;
+        dataLen -= n;
+    }
+
+    return NATS_OK;
+}
+
+void
+natsSegBuf_Truncate(natsSegBuffer *buf, int64_t newLen)
+{
+    natsSegChunk    *chunk = buf->head;
+    int64_t         n;
+
+    if (newLen >= buf->len)
+        return;
+
+    if (newLen <= 0)
+    {
+        natsSegBuf_Reset(buf);
+        return;
+    }
+
+    // Find the chunk that contains the new end of the buffer.
+    n = newLen + buf->headPos;
+    while (n > chunk->len)
+    {
+        n -= chunk->len;
+        chunk = chunk->next;
+    }
+
+    chunk->len = (int) n;
+    _releaseChunks(buf, chunk->next);
+    chunk->next = NULL;
+
+    buf->tail = chunk;
+    buf->len  = newLen;
+}
+
+void
+natsSegBuf_Consume(natsSegBuffer *buf, int64_t n)
+{
+    natsSegChunk    *chunk;
+    int             avail;
+
+    if (n >= buf->len)
+    {
+        natsSegBuf_Reset(buf);
+        return;
+    }
+
+    buf->len -= n;
+
+    while (n > 0)
+    {
+        chunk = buf->head;
+        avail = chunk->len - buf->headPos;
+
+        if (n < (int64_t) avail)
+        {
+            buf->headPos += (int) n;
+            break;
+        }
+
+        n -= avail;
+
+        buf->head    = chunk->next;
+        buf->headPos = 0;
+        _releaseChunk(buf, chunk);
+    }
+
+    if (buf->head == NULL)
+        buf->tail = NULL;
+}
+
+int
+natsSegBuf_GetIOV(natsSegBuffer *buf, natsIOVec *iov, int maxIov, int64_t *bytes)
+{
+    natsSegChunk    *chunk;
+    int             pos;
+    int             count = 0;
+
+    *bytes = 0;
+
+    for (chunk = buf->head; (chunk != NULL) && (count < maxIov); chunk = chunk->next)
+    {
+        pos = (chunk == buf->head ? buf->headPos : 0);
+        if (chunk->len == pos)
+            continue;
+
+        iov[count].iov_base = chunk->data + pos;
+        iov[count].iov_len  = (size_t) (chunk->len - pos);
+        *bytes += (int64_t) (chunk->len - pos);
+        count++;
+    }
+
+    return count;
+}
+
+void
+natsSegBuf_Reset(natsSegBuffer *buf)
+{
+    _releaseChunks(buf, buf->head);
+
+    buf->head    = NULL;
+    buf->tail    = NULL;
+    buf->headPos = 0;
+    buf->len     = 0;
+}
+
+void
+natsSegBuf_Destroy(natsSegBuffer *buf)
+{
+    natsSegChunk *chunk;
+
+    if (buf == NULL)
+        return;
+
+    natsSegBuf_Reset(buf);
+
+    while ((chunk = buf->free) != NULL)
+    {
+        buf->free = chunk->next;
+        NATS_FREE(chunk);
+    }
+
+    NATS_FREE(buf);
+}
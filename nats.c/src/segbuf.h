@@ -0,0 +1,85 @@
+// Copyright 2020 The NATS Authors
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SEGBUF_H_
+#define SEGBUF_H_
+
+#include "nats.h"
+
+// Maximum number of free chunks kept for reuse by a segmented buffer.
+#define NATS_SEGBUF_MAX_FREE_CHUNKS (4)
+
+typedef struct __natsSegChunk
+{
+    char                    *data;
+    int                     len;
+    struct __natsSegChunk   *next;
+
+} natsSegChunk;
+
+// A segmented buffer is a list of fixed-size chunks. Data is appended
+// to the last chunk, and new chunks are added as needed, so that data
+// already in the buffer is never moved (there is no reallocation).
+// Data is consumed from the first chunk. Chunks that are no longer
+// needed are kept in a small free list for reuse.
+typedef struct __natsSegBuffer
+{
+    natsSegChunk    *head;
+    natsSegChunk    *tail;
+    natsSegChunk    *free;
+    int             freeCount;
+    int             chunkSize;
+    // Number of bytes of the head chunk that have been consumed.
+    int             headPos;
+    int64_t         len;
+
+} natsSegBuffer;
+
+#define natsSegBuf_Len(b)   ((b)->len)
+
+// Creates a segmented buffer that will use chunks of 'chunkSize' bytes.
+// No chunk is allocated until data is appended.
+natsStatus
+natsSegBuf_Create(natsSegBuffer **newBuf, int chunkSize);
+
+// Appends 'dataLen' bytes from 'data', adding chunks as needed.
+natsStatus
+natsSegBuf_Append(natsSegBuffer *buf, const char *data, int dataLen);
+
+// Sets the length of the buffer to 'newLen', which must not be greater
+// than the current length. This is used to discard data that has been
+// appended after a given position.
+void
+natsSegBuf_Truncate(natsSegBuffer *buf, int64_t newLen);
+
+// Removes the first 'n' bytes of the buffer. Chunks that become empty
+// are released.
+void
+natsSegBuf_Consume(natsSegBuffer *buf, int64_t n);
+
+// Fills at most 'maxIov' elements of 'iov' with the content of the buffer,
+// starting with the first byte that has not been consumed. Returns the
+// number of elements that have been set, and the total number of bytes
+// they reference in 'bytes'. The content of the buffer is not modified.
+int
+natsSegBuf_GetIOV(natsSegBuffer *buf, natsIOVec *iov, int maxIov, int64_t *bytes);
+
+// Discards all data. Chunks are released.
+void
+natsSegBuf_Reset(natsSegBuffer *buf);
+
+// Frees all chunks, including the ones kept for reuse, and the buffer itself.
+void
+natsSegBuf_Destroy(natsSegBuffer *buf);
+
+#endif /* SEGBUF_H_ */
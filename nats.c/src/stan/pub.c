@@ -157,7 +157,7 @@ _pubAckTimerCB(natsTimer *timer, void* closure)
         closed = sc->pubAckClosed;
         if (sc->pubAckHead != NULL)
         {
-            int64_t now = nats_Now();
+            int64_t now = nats_coarseNow();
 
             pa = sc->pubAckHead;
 
@@ -342,7 +342,7 @@ _stanPublish(stanConnection *sc, const char *channel, const void *data, int data
                 if (s == NATS_OK)
                 {
                     // Compute absolute time based on current time and the pub ack timeout.
-                    ackTimeout = nats_Now() + sc->opts->pubAckTimeout;
+                    ackTimeout = nats_coarseNow() + sc->opts->pubAckTimeout;
 
                     // For Publish() calls, store in map, no need to copy keep since it is in pa.
                     if (isSync)
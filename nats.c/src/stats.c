@@ -55,6 +55,36 @@ natsStatistics_GetCounts(natsStatistics *stats,
     return NATS_OK;
 }
 
+natsStatus
+natsStatistics_GetFlushCounts(natsStatistics *stats,
+                              uint64_t *flushes, uint64_t *avgBytesPerFlush)
+{
+    if (stats == NULL)
+        return nats_setDefaultError(NATS_INVALID_ARG);
+
+    if (flushes != NULL)
+        *flushes = stats->flushes;
+    if (avgBytesPerFlush != NULL)
+        *avgBytesPerFlush = (stats->flushes > 0 ? stats->flushedBytes / stats->flushes : 0);
+
+    return NATS_OK;
+}
+
+natsStatus
+natsStatistics_GetMsgPoolCounts(natsStatistics *stats,
+                                uint64_t *hits, uint64_t *misses)
+{
+    if (stats == NULL)
+        return nats_setDefaultError(NATS_INVALID_ARG);
+
+    if (hits != NULL)
+        *hits = stats->msgPoolHits;
+    if (misses != NULL)
+        *misses = stats->msgPoolMisses;
+
+    return NATS_OK;
+}
+
 void
 natsStatistics_Destroy(natsStatistics *stats)
 {
@@ -26,6 +26,10 @@ struct __natsStatistics
     uint64_t    inBytes;
     uint64_t    outBytes;
     uint64_t    reconnects;
+    uint64_t    flushes;
+    uint64_t    flushedBytes;
+    uint64_t    msgPoolHits;
+    uint64_t    msgPoolMisses;
 
 };
 
@@ -66,6 +66,8 @@ static const char *statusText[] = {
     "Draining in progress",
 
     "Invalid queue name",
+
+    "Outbound Limit Reached",
 };
 
 const char*
@@ -124,6 +124,10 @@ typedef enum
 
     NATS_INVALID_QUEUE_NAME,            ///< An invalid queue name was passed when creating a queue subscription.
 
+    NATS_OUTBOUND_LIMIT_REACHED,        ///< The data could not be published because the connection already
+                                        ///  buffers the maximum number of outbound bytes. See
+                                        ///  #natsOptions_SetMaxOutboundBytes().
+
 } natsStatus;
 
 #ifdef __cplusplus
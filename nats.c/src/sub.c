@@ -46,25 +46,35 @@ void natsSub_Unlock(natsSubscription *sub)   { natsMutex_Unlock(sub->mu); }
 static void
 _freeSubscription(natsSubscription *sub)
 {
-    natsMsg *m;
+    int i;
 
     if (sub == NULL)
         return;
 
-    while ((m = sub->msgList.head) != NULL)
-    {
-        sub->msgList.head = m->next;
-        natsMsg_Destroy(m);
-    }
+    natsMsgQueue_Clear(&(sub->msgQ));
 
     NATS_FREE(sub->subject);
     NATS_FREE(sub->queue);
+    NATS_FREE(sub->msgBatch);
 
     if (sub->deliverMsgsThread != NULL)
     {
         natsThread_Detach(sub->deliverMsgsThread);
         natsThread_Destroy(sub->deliverMsgsThread);
     }
+    for (i=0; i<sub->numLanes; i++)
+    {
+        natsSubLane *lane = &(sub->lanes[i]);
+
+        if (lane->thread != NULL)
+        {
+            natsThread_Detach(lane->thread);
+            natsThread_Destroy(lane->thread);
+        }
+        natsMsgQueue_Clear(&(lane->msgQ));
+        natsCondition_Destroy(lane->cond);
+    }
+    NATS_FREE(sub->lanes);
     natsTimer_Destroy(sub->timeoutTimer);
     natsCondition_Destroy(sub->cond);
     natsMutex_Destroy(sub->mu);
@@ -102,6 +112,21 @@ natsSub_release(natsSubscription *sub)
         _freeSubscription(sub);
 }
 
+// Spins on the subscription's queue before the caller possibly parks, for
+// the busy poll time if one is set. Returns true if the queue is not empty.
+// Must be called only by the queue's sole consumer.
+static bool
+_spinForMsgs(natsSubscription *sub)
+{
+    if (!natsMsgQueue_IsEmpty(&(sub->msgQ)))
+        return true;
+
+    if (sub->busyPoll > 0)
+        return natsMsgQueue_SpinFor(&(sub->msgQ), sub->busyPoll);
+
+    return natsMsgQueue_Spin(&(sub->msgQ), NATS_MSG_QUEUE_SPIN_COUNT);
+}
+
 // _deliverMsgs is used to deliver messages to asynchronous subscribers.
 void
 natsSub_deliverMsgs(void *arg)
@@ -130,22 +155,32 @@ natsSub_deliverMsgs(void *arg)
 
     while (true)
     {
+        // This thread is the only consumer, so it can check the queue
+        // without the lock. Spin for a bit before possibly parking.
+        (void) _spinForMsgs(sub);
+
         natsSub_Lock(sub);
 
         s = NATS_OK;
-        while (((msg = sub->msgList.head) == NULL) && !(sub->closed) && !(sub->draining) && (s != NATS_TIMEOUT))
+        while (((msg = natsMsgQueue_Pop(&(sub->msgQ))) == NULL) && !(sub->closed) && !(sub->draining) && (s != NATS_TIMEOUT))
         {
-            sub->inWait++;
-            if (timeout != 0)
-                s = natsCondition_TimedWait(sub->cond, sub->mu, timeout);
-            else
-                natsCondition_Wait(sub->cond, sub->mu);
-            sub->inWait--;
+            // Producers check this after pushing, so the queue needs to
+            // be checked again before waiting.
+            nats_atomicInc(&(sub->inWait));
+            if (natsMsgQueue_IsEmpty(&(sub->msgQ)))
+            {
+                if (timeout != 0)
+                    s = natsCondition_TimedWait(sub->cond, sub->mu, timeout);
+                else
+                    natsCondition_Wait(sub->cond, sub->mu);
+            }
+            nats_atomicDec(&(sub->inWait));
         }
 
         if (sub->closed)
         {
             natsSub_Unlock(sub);
+            natsMsg_Destroy(msg);
             break;
         }
         draining = sub->draining;
@@ -167,15 +202,8 @@ natsSub_deliverMsgs(void *arg)
 
         delivered = ++(sub->delivered);
 
-        sub->msgList.head = msg->next;
-
-        if (sub->msgList.tail == msg)
-            sub->msgList.tail = NULL;
-
-        sub->msgList.msgs--;
-        sub->msgList.bytes -= msg->dataLen;
-
-        msg->next = NULL;
+        nats_atomicDec(&(sub->pendingMsgs));
+        nats_atomicAdd(&(sub->pendingBytes), -(msg->dataLen));
 
         // Capture this under lock.
         max = sub->max;
@@ -215,6 +243,417 @@ natsSub_deliverMsgs(void *arg)
     natsSub_release(sub);
 }
 
+// Same than natsSub_deliverMsgs, but collects up to 'maxBatch' messages
+// for each invocation of the batch callback.
+void
+natsSub_deliverMsgBatches(void *arg)
+{
+    natsSubscription    *sub        = (natsSubscription*) arg;
+    natsConnection      *nc         = sub->conn;
+    natsMsgBatchHandler bcb         = sub->msgBatchCb;
+    void                *bcbClosure = sub->msgCbClosure;
+    natsMsg             **msgs      = sub->msgBatch;
+    int                 maxBatch    = sub->maxBatch;
+    int64_t             linger      = sub->batchLinger;
+    int                 count       = 0;
+    uint64_t            delivered;
+    uint64_t            max;
+    natsMsg             *msg;
+    int64_t             timeout;
+    int64_t             deadline;
+    natsStatus          s = NATS_OK;
+    bool                draining = false;
+    bool                rmSub    = false;
+    natsOnCompleteCB    onCompleteCB = NULL;
+    void                *onCompleteCBClosure = NULL;
+    int                 i;
+
+    // This just serves as a barrier for the creation of this thread.
+    natsConn_Lock(nc);
+    natsConn_Unlock(nc);
+
+    natsSub_Lock(sub);
+    timeout = sub->timeout;
+    natsSub_Unlock(sub);
+
+    while (true)
+    {
+        // This thread is the only consumer, so it can check the queue
+        // without the lock. Spin for a bit before possibly parking.
+        (void) _spinForMsgs(sub);
+
+        natsSub_Lock(sub);
+
+        s        = NATS_OK;
+        count    = 0;
+        deadline = 0;
+
+        // Collect messages until the batch is full, or we have reached
+        // the max, or the linger time has elapsed.
+        while (!(sub->closed)
+               && (count < maxBatch)
+               && ((sub->max == 0) || (sub->delivered < sub->max)))
+        {
+            if ((msg = natsMsgQueue_Pop(&(sub->msgQ))) != NULL)
+            {
+                nats_atomicDec(&(sub->pendingMsgs));
+                nats_atomicAdd(&(sub->pendingBytes), -(msg->dataLen));
+
+                sub->delivered++;
+                msgs[count++] = msg;
+                continue;
+            }
+
+            if (sub->draining || (s == NATS_TIMEOUT))
+                break;
+
+            if (count > 0)
+            {
+                if (linger <= 0)
+                    break;
+
+                if (deadline == 0)
+                    deadline = nats_monotonicNow() + linger;
+            }
+
+            // Producers check this after pushing, so the queue needs to
+            // be checked again before waiting.
+            nats_atomicInc(&(sub->inWait));
+            if (natsMsgQueue_IsEmpty(&(sub->msgQ)))
+            {
+                if (count > 0)
+                    s = natsCondition_AbsoluteTimedWait(sub->cond, sub->mu, deadline);
+                else if (timeout != 0)
+                    s = natsCondition_TimedWait(sub->cond, sub->mu, timeout);
+                else
+                    natsCondition_Wait(sub->cond, sub->mu);
+            }
+            nats_atomicDec(&(sub->inWait));
+        }
+
+        if (sub->closed)
+        {
+            natsSub_Unlock(sub);
+            for (i=0; i<count; i++)
+                natsMsg_Destroy(msgs[i]);
+            break;
+        }
+        draining  = sub->draining;
+        delivered = sub->delivered;
+
+        // Capture this under lock.
+        max = sub->max;
+
+        natsSub_Unlock(sub);
+
+        if (count > 0)
+        {
+            (*bcb)(nc, sub, msgs, count, bcbClosure);
+        }
+        else if (draining)
+        {
+            // Nothing left to deliver.
+            rmSub = true;
+            break;
+        }
+        else if ((s == NATS_TIMEOUT) && ((max == 0) || (delivered < max)))
+        {
+            // If subscription timed-out, invoke callback with no message.
+            (*bcb)(nc, sub, NULL, 0, bcbClosure);
+        }
+
+        if ((max > 0) && (delivered >= max))
+        {
+            // If we have hit the max for delivered msgs, remove sub.
+            rmSub = true;
+            break;
+        }
+    }
+    if (rmSub)
+        natsConn_removeSubscription(nc, sub);
+
+    natsSub_Lock(sub);
+    onCompleteCB        = sub->onCompleteCB;
+    onCompleteCBClosure = sub->onCompleteCBClosure;
+    natsSub_Unlock(sub);
+
+    if (onCompleteCB != NULL)
+        (*onCompleteCB)(onCompleteCBClosure);
+
+    natsSub_release(sub);
+}
+
+// Same than natsSub_deliverMsgs, but for one of the delivery threads of
+// a parallel subscription. The subscription is removed by the lane that
+// reaches the max, or by the last lane to be done when draining.
+void
+natsSub_deliverLaneMsgs(void *arg)
+{
+    natsSubLane         *lane       = (natsSubLane*) arg;
+    natsSubscription    *sub        = lane->sub;
+    natsConnection      *nc         = sub->conn;
+    natsMsgHandler      mcb         = sub->msgCb;
+    void                *mcbClosure = sub->msgCbClosure;
+    natsMsgQueue        *q          = &(lane->msgQ);
+    natsCondition       *cond       = lane->cond;
+    natsAtomicInt       *inWait     = &(lane->inWait);
+    uint64_t            delivered;
+    uint64_t            max;
+    natsMsg             *msg;
+    bool                rmSub    = false;
+    bool                last     = false;
+    natsOnCompleteCB    onCompleteCB = NULL;
+    void                *onCompleteCBClosure = NULL;
+
+    // This just serves as a barrier for the creation of this thread.
+    natsConn_Lock(nc);
+    natsConn_Unlock(nc);
+
+    if (sub->laneOrder == NATS_PARALLEL_UNORDERED)
+    {
+        q      = &(sub->msgQ);
+        cond   = sub->cond;
+        inWait = &(sub->inWait);
+    }
+
+    natsSub_Lock(sub);
+
+    while (true)
+    {
+        // The queue may be shared with other lanes, so without the lock,
+        // only the producer side is checked (see natsMsgQueue_Spin()).
+        if ((sub->busyPoll > 0) && natsMsgQueue_IsEmpty(q))
+        {
+            natsSub_Unlock(sub);
+            (void) natsMsgQueue_SpinFor(q, sub->busyPoll);
+            natsSub_Lock(sub);
+        }
+
+        while (((msg = natsMsgQueue_Pop(q)) == NULL) && !(sub->closed) && !(sub->draining))
+        {
+            // Producers check this after pushing, so the queue needs to
+            // be checked again before waiting.
+            nats_atomicInc(inWait);
+            if (natsMsgQueue_IsEmpty(q))
+                natsCondition_Wait(cond, sub->mu);
+            nats_atomicDec(inWait);
+        }
+
+        if (sub->closed)
+        {
+            natsMsg_Destroy(msg);
+            break;
+        }
+
+        // Draining and nothing left for this lane. The last lane to get
+        // there removes the subscription, the others wait for the close.
+        if (msg == NULL)
+        {
+            if (++(sub->lanesDrained) == sub->numLanes)
+            {
+                rmSub = true;
+                break;
+            }
+            while (!(sub->closed))
+                natsCondition_Wait(cond, sub->mu);
+
+            break;
+        }
+
+        delivered = ++(sub->delivered);
+
+        nats_atomicDec(&(sub->pendingMsgs));
+        nats_atomicAdd(&(sub->pendingBytes), -(msg->dataLen));
+
+        // Capture this under lock.
+        max = sub->max;
+
+        natsSub_Unlock(sub);
+
+        if ((max == 0) || (delivered <= max))
+        {
+           (*mcb)(nc, sub, msg, mcbClosure);
+        }
+        else
+        {
+            // We need to destroy the message since the user can't do it
+            natsMsg_Destroy(msg);
+        }
+
+        // Other lanes may still be invoking the callback for messages
+        // below the max, and will find the subscription closed next.
+        if ((max > 0) && (delivered >= max))
+            natsConn_removeSubscription(nc, sub);
+
+        natsSub_Lock(sub);
+    }
+
+    natsSub_Unlock(sub);
+
+    if (rmSub)
+        natsConn_removeSubscription(nc, sub);
+
+    natsSub_Lock(sub);
+    last                = (--(sub->lanesRunning) == 0);
+    onCompleteCB        = sub->onCompleteCB;
+    onCompleteCBClosure = sub->onCompleteCBClosure;
+    natsSub_Unlock(sub);
+
+    if (last && (onCompleteCB != NULL))
+        (*onCompleteCB)(onCompleteCBClosure);
+
+    natsSub_release(sub);
+}
+
+void
+natsSub_dispatchToLanes(natsSubscription *sub, natsMsg *head)
+{
+    natsMsg     *msg;
+    natsMsg     *next;
+    natsSubLane *lane;
+    uint64_t    key;
+    int         i;
+
+    for (msg = head; msg != NULL; msg = next)
+    {
+        next      = msg->next;
+        msg->next = NULL;
+
+        if (sub->laneOrder == NATS_PARALLEL_ORDER_BY_SUBJECT)
+        {
+            key = (uint64_t) natsStrHash_Hash(msg->subject, (int) strlen(msg->subject));
+        }
+        else
+        {
+            // Spread keys that differ only by their high bits.
+            key = (*(sub->laneKeyCb))(msg, sub->msgCbClosure);
+            key = ((key * 0x9E3779B97F4A7C15ULL) >> 32);
+        }
+
+        lane = &(sub->lanes[key % (uint64_t) sub->numLanes]);
+
+        if (lane->dispatchHead == NULL)
+            lane->dispatchHead = msg;
+        else
+            lane->dispatchTail->next = msg;
+
+        lane->dispatchTail = msg;
+    }
+
+    for (i=0; i<sub->numLanes; i++)
+    {
+        lane = &(sub->lanes[i]);
+        if (lane->dispatchHead == NULL)
+            continue;
+
+        if (natsMsgQueue_Push(&(lane->msgQ), lane->dispatchHead)
+            && (nats_atomicGet(&(lane->inWait)) > 0))
+        {
+            natsSub_Lock(sub);
+            natsCondition_Broadcast(lane->cond);
+            natsSub_Unlock(sub);
+        }
+
+        lane->dispatchHead = NULL;
+        lane->dispatchTail = NULL;
+    }
+}
+
+void
+natsSub_deliverInline(natsSubscription *sub, natsMsg *head)
+{
+    natsConnection  *nc         = sub->conn;
+    natsMsgHandler  mcb         = sub->msgCb;
+    void            *mcbClosure = sub->msgCbClosure;
+    natsMsg         *msg;
+    natsMsg         *next;
+    uint64_t        delivered   = 0;
+    uint64_t        max;
+    bool            closed;
+
+    nats_setInlineDeliveryConn(nc);
+
+    for (msg = head; msg != NULL; msg = next)
+    {
+        next      = msg->next;
+        msg->next = NULL;
+
+        natsSub_Lock(sub);
+        closed = sub->closed;
+        if (!closed)
+            delivered = ++(sub->delivered);
+        max = sub->max;
+        natsSub_Unlock(sub);
+
+        if (closed || ((max > 0) && (delivered > max)))
+        {
+            natsMsg_Destroy(msg);
+            continue;
+        }
+
+        (*mcb)(nc, sub, msg, mcbClosure);
+
+        if ((max > 0) && (delivered >= max))
+            natsConn_removeSubscription(nc, sub);
+    }
+
+    nats_setInlineDeliveryConn(NULL);
+}
+
+// Wakes up the delivery thread(s) of the subscription, which must be
+// locked.
+static void
+_signalDelivery(natsSubscription *sub)
+{
+    int i;
+
+    natsCondition_Broadcast(sub->cond);
+
+    for (i=0; i<sub->numLanes; i++)
+    {
+        if (sub->lanes[i].cond != NULL)
+            natsCondition_Broadcast(sub->lanes[i].cond);
+    }
+}
+
+static natsStatus
+_createLanes(natsSubscription *sub, int lanes, natsParallelOrder order,
+             natsMsgKeyHandler keyCb)
+{
+    natsStatus  s = NATS_OK;
+    int         i;
+
+    sub->lanes = (natsSubLane*) NATS_CALLOC(lanes, sizeof(natsSubLane));
+    if (sub->lanes == NULL)
+        return nats_setDefaultError(NATS_NO_MEMORY);
+
+    sub->numLanes  = lanes;
+    sub->laneOrder = order;
+    sub->laneKeyCb = keyCb;
+
+    for (i=0; (s == NATS_OK) && (i<lanes); i++)
+    {
+        sub->lanes[i].sub = sub;
+        if (order != NATS_PARALLEL_UNORDERED)
+            s = natsCondition_Create(&(sub->lanes[i].cond));
+    }
+    for (i=0; (s == NATS_OK) && (i<lanes); i++)
+    {
+        _retain(sub);
+        sub->lanesRunning++;
+
+        s = natsThread_Create(&(sub->lanes[i].thread), natsSub_deliverLaneMsgs,
+                              (void*) &(sub->lanes[i]));
+        if (s != NATS_OK)
+        {
+            sub->lanesRunning--;
+            _release(sub);
+        }
+    }
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
 void
 natsSub_setMax(natsSubscription *sub, uint64_t max)
 {
@@ -270,7 +709,7 @@ natsSub_close(natsSubscription *sub, bool connectionClosed)
             natsLib_msgDeliveryPostControlMsg(sub);
         }
         else
-            natsCondition_Broadcast(sub->cond);
+            _signalDelivery(sub);
     }
 
     SUB_DLV_WORKER_UNLOCK(sub);
@@ -281,7 +720,8 @@ natsSub_close(natsSubscription *sub, bool connectionClosed)
 static void
 _asyncTimeoutCb(natsTimer *timer, void* closure)
 {
-    natsSubscription *sub = (natsSubscription*) closure;
+    natsSubscription    *sub = (natsSubscription*) closure;
+    int64_t             remaining;
 
     // Should not happen, but in case
     if (sub->libDlvWorker == NULL)
@@ -289,20 +729,35 @@ _asyncTimeoutCb(natsTimer *timer, void* closure)
 
     SUB_DLV_WORKER_LOCK(sub);
 
-    // If the subscription is closed, or if we are prevented from posting
-    // a "timeout" control message, do nothing.
-    if (!sub->closed && !sub->timedOut && !sub->timeoutSuspended)
+    // If the subscription is closed, or if a "timeout" control message has
+    // already been posted, do nothing.
+    if (!sub->closed && !sub->timedOut)
     {
-        // Prevent from scheduling another control message while we are not
-        // done with previous one.
-        sub->timedOut = true;
+        if (sub->timeoutSuspended)
+        {
+            // Messages are being delivered, check again in `timeout` (the
+            // interval may have been changed below).
+            natsTimer_Reset(sub->timeoutTimer, sub->timeout);
+        }
+        else if ((remaining = sub->lastActivity + sub->timeout - nats_coarseNow()) > 0)
+        {
+            // Messages have been delivered since the timer was set, so fire
+            // when the timeout expires from the last one.
+            natsTimer_Reset(sub->timeoutTimer, remaining);
+        }
+        else
+        {
+            // Prevent from scheduling another control message while we are
+            // not done with previous one.
+            sub->timedOut = true;
 
-        // Set the timer to a very high value, it will be reset from the
-        // worker thread.
-        natsTimer_Reset(sub->timeoutTimer, 60*60*1000);
+            // Set the timer to a very high value, it will be reset from the
+            // worker thread.
+            natsTimer_Reset(sub->timeoutTimer, 60*60*1000);
 
-        // Post a control message to the worker thread.
-        natsLib_msgDeliveryPostControlMsg(sub);
+            // Post a control message to the worker thread.
+            natsLib_msgDeliveryPostControlMsg(sub);
+        }
     }
 
     SUB_DLV_WORKER_UNLOCK(sub);
@@ -319,7 +774,9 @@ _asyncTimeoutStopCb(natsTimer *timer, void* closure)
 natsStatus
 natsSub_create(natsSubscription **newSub, natsConnection *nc, const char *subj,
                const char *queueGroup, int64_t timeout, natsMsgHandler cb, void *cbClosure,
-               bool preventUseOfLibDlvPool)
+               natsMsgBatchHandler batchCb, int maxBatch, int64_t linger,
+               int lanes, natsParallelOrder order, natsMsgKeyHandler keyCb,
+               bool inlineDlv, bool preventUseOfLibDlvPool)
 {
     natsStatus          s = NATS_OK;
     natsSubscription    *sub = NULL;
@@ -343,6 +800,7 @@ natsSub_create(natsSubscription **newSub, natsConnection *nc, const char *subj,
     sub->msgCb          = cb;
     sub->msgCbClosure   = cbClosure;
     sub->msgsLimit      = nc->opts->maxPendingMsgs;
+    sub->busyPoll       = nc->opts->busyPoll * 1000;
     sub->bytesLimit     = sub->msgsLimit * 1024;
 
     if (sub->bytesLimit <= 0)
@@ -360,7 +818,38 @@ natsSub_create(natsSubscription **newSub, natsConnection *nc, const char *subj,
     }
     if (s == NATS_OK)
         s = natsCondition_Create(&(sub->cond));
-    if ((s == NATS_OK) && (cb != NULL))
+    if ((s == NATS_OK) && (batchCb != NULL))
+    {
+        sub->msgBatchCb  = batchCb;
+        sub->maxBatch    = maxBatch;
+        sub->batchLinger = linger;
+
+        sub->msgBatch = (natsMsg**) NATS_CALLOC(maxBatch, sizeof(natsMsg*));
+        if (sub->msgBatch == NULL)
+            s = nats_setDefaultError(NATS_NO_MEMORY);
+
+        // Batches are always delivered by a sub specific thread.
+        if (s == NATS_OK)
+        {
+            _retain(sub);
+
+            s = natsThread_Create(&(sub->deliverMsgsThread), natsSub_deliverMsgBatches,
+                                  (void*) sub);
+            if (s != NATS_OK)
+                _release(sub);
+        }
+    }
+    else if ((s == NATS_OK) && (cb != NULL) && inlineDlv)
+    {
+        // Messages are delivered by the connection's reading thread.
+        sub->inlineDlv = true;
+    }
+    else if ((s == NATS_OK) && (cb != NULL) && (lanes > 0))
+    {
+        // Lanes always have their own thread.
+        s = _createLanes(sub, lanes, order, keyCb);
+    }
+    else if ((s == NATS_OK) && (cb != NULL))
     {
         if (!(nc->opts->libMsgDelivery) || preventUseOfLibDlvPool)
         {
@@ -381,6 +870,8 @@ natsSub_create(natsSubscription **newSub, natsConnection *nc, const char *subj,
             s = natsLib_msgDeliveryAssignWorker(sub);
             if ((s == NATS_OK) && (timeout > 0))
             {
+                sub->lastActivity = nats_coarseNow();
+
                 _retain(sub);
                 s = natsTimer_Create(&sub->timeoutTimer, _asyncTimeoutCb,
                                      _asyncTimeoutStopCb, timeout, (void*) sub);
@@ -393,9 +884,18 @@ natsSub_create(natsSubscription **newSub, natsConnection *nc, const char *subj,
     }
 
     if (s == NATS_OK)
+    {
         *newSub = sub;
+    }
     else
+    {
+        // Lanes that have been started exit once they see the subscription
+        // closed.
+        if (sub->lanesRunning > 0)
+            natsSub_close(sub, false);
+
         natsSub_release(sub);
+    }
 
     return NATS_UPDATE_ERR_STACK(s);
 }
@@ -442,6 +942,72 @@ natsConnection_SubscribeTimeout(natsSubscription **sub, natsConnection *nc, cons
 }
 
 
+natsStatus
+natsConnection_SubscribeBatch(natsSubscription **sub, natsConnection *nc, const char *subject,
+                              int maxBatch, int64_t linger,
+                              natsMsgBatchHandler cb, void *cbClosure)
+{
+    natsStatus s;
+
+    if ((cb == NULL) || (maxBatch <= 0) || (linger < 0))
+        return nats_setDefaultError(NATS_INVALID_ARG);
+
+    s = natsConn_subscribeBatch(sub, nc, subject, 0, maxBatch, linger, cb, cbClosure);
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
+natsStatus
+natsConnection_SubscribeBatchTimeout(natsSubscription **sub, natsConnection *nc, const char *subject,
+                                     int maxBatch, int64_t linger, int64_t timeout,
+                                     natsMsgBatchHandler cb, void *cbClosure)
+{
+    natsStatus s;
+
+    if ((cb == NULL) || (maxBatch <= 0) || (linger < 0) || (timeout <= 0))
+        return nats_setDefaultError(NATS_INVALID_ARG);
+
+    s = natsConn_subscribeBatch(sub, nc, subject, timeout, maxBatch, linger, cb, cbClosure);
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
+natsStatus
+natsConnection_SubscribeParallel(natsSubscription **sub, natsConnection *nc, const char *subject,
+                                 int lanes, natsParallelOrder order, natsMsgKeyHandler keyCb,
+                                 natsMsgHandler cb, void *cbClosure)
+{
+    natsStatus s;
+
+    if ((cb == NULL)
+        || (lanes <= 0)
+        || ((order != NATS_PARALLEL_UNORDERED)
+            && (order != NATS_PARALLEL_ORDER_BY_SUBJECT)
+            && (order != NATS_PARALLEL_ORDER_BY_KEY))
+        || ((order == NATS_PARALLEL_ORDER_BY_KEY) != (keyCb != NULL)))
+    {
+        return nats_setDefaultError(NATS_INVALID_ARG);
+    }
+
+    s = natsConn_subscribeParallel(sub, nc, subject, lanes, order, keyCb, cb, cbClosure);
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
+natsStatus
+natsConnection_SubscribeInline(natsSubscription **sub, natsConnection *nc, const char *subject,
+                               natsMsgHandler cb, void *cbClosure)
+{
+    natsStatus s;
+
+    if (cb == NULL)
+        return nats_setDefaultError(NATS_INVALID_ARG);
+
+    s = natsConn_subscribeInline(sub, nc, subject, cb, cbClosure);
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
 /*
  * natsSubscribeSync is syntactic sugar for natsSubscribe(&sub, nc, subject, NULL).
  */
@@ -537,31 +1103,19 @@ natsSubscription_NoDeliveryDelay(natsSubscription *sub)
 }
 
 
-/*
- * Return the next message available to a synchronous subscriber or block until
- * one is available. A timeout can be used to return when no message has been
- * delivered.
- */
-natsStatus
-natsSubscription_NextMsg(natsMsg **nextMsg, natsSubscription *sub, int64_t timeout)
+// Checks that messages can be returned from this subscription and waits up
+// to 'timeout' milliseconds for one to be available. Returns NATS_OK if
+// there is a message, or if the subscription is draining.
+// Sub lock held on entry.
+static natsStatus
+_waitForMsgs(natsSubscription *sub, int64_t timeout)
 {
-    natsStatus      s    = NATS_OK;
-    natsConnection  *nc  = NULL;
-    natsMsg         *msg = NULL;
-    bool            removeSub = false;
-    int64_t         target    = 0;
-
-    if ((sub == NULL) || (nextMsg == NULL))
-        return nats_setDefaultError(NATS_INVALID_ARG);
-
-    natsSub_Lock(sub);
+    natsStatus      s       = NATS_OK;
+    int64_t         target  = 0;
 
     if (sub->connClosed)
-    {
-        natsSub_Unlock(sub);
-
         return nats_setDefaultError(NATS_CONNECTION_CLOSED);
-    }
+
     if (sub->closed)
     {
         if ((sub->max > 0) && (sub->delivered >= sub->max))
@@ -569,44 +1123,54 @@ natsSubscription_NextMsg(natsMsg **nextMsg, natsSubscription *sub, int64_t timeo
         else
             s = NATS_INVALID_SUBSCRIPTION;
 
-        natsSub_Unlock(sub);
-
         return nats_setDefaultError(s);
     }
-    if (sub->msgCb != NULL)
-    {
-        natsSub_Unlock(sub);
-
+    if ((sub->msgCb != NULL) || (sub->msgBatchCb != NULL))
         return nats_setDefaultError(NATS_ILLEGAL_STATE);
-    }
+
+    // Messages for this subscription would be read by the thread waiting
+    // for them.
+    if ((timeout > 0) && nats_isInlineDeliveryConn(sub->conn))
+        return nats_setError(NATS_ILLEGAL_STATE, "%s", INLINE_DLV_BLOCKING_ERR);
+
     if (sub->slowConsumer)
     {
         sub->slowConsumer = false;
-        natsSub_Unlock(sub);
 
         return nats_setDefaultError(NATS_SLOW_CONSUMER);
     }
 
-    nc = sub->conn;
-
     if (timeout > 0)
     {
-        sub->inWait++;
+        // With busy polling, wait for a message without the lock before
+        // possibly parking. Other callers may pop concurrently, so only
+        // the producer side is checked (see natsMsgQueue_Spin()), and the
+        // state is checked again below.
+        if ((sub->busyPoll > 0) && natsMsgQueue_IsEmpty(&(sub->msgQ)))
+        {
+            natsSub_Unlock(sub);
+            (void) natsMsgQueue_SpinFor(&(sub->msgQ), sub->busyPoll);
+            natsSub_Lock(sub);
+        }
+
+        // Producers check this after pushing, so set it before checking
+        // the queue.
+        nats_atomicInc(&(sub->inWait));
 
-        while ((sub->msgList.msgs == 0)
+        while (natsMsgQueue_IsEmpty(&(sub->msgQ))
                && (s != NATS_TIMEOUT)
                && !(sub->closed)
                && !(sub->draining))
         {
             if (target == 0)
-                target = nats_Now() + timeout;
+                target = nats_monotonicNow() + timeout;
 
             s = natsCondition_AbsoluteTimedWait(sub->cond, sub->mu, target);
             if (s != NATS_OK)
                 s = nats_setDefaultError(s);
         }
 
-        sub->inWait--;
+        nats_atomicDec(&(sub->inWait));
 
         if (sub->connClosed)
             s = nats_setDefaultError(NATS_CONNECTION_CLOSED);
@@ -615,14 +1179,38 @@ natsSubscription_NextMsg(natsMsg **nextMsg, natsSubscription *sub, int64_t timeo
     }
     else
     {
-        s = (sub->msgList.msgs == 0 ? NATS_TIMEOUT : NATS_OK);
+        s = (natsMsgQueue_IsEmpty(&(sub->msgQ)) ? NATS_TIMEOUT : NATS_OK);
         if (s != NATS_OK)
             s = nats_setDefaultError(s);
     }
 
+    return s;
+}
+
+/*
+ * Return the next message available to a synchronous subscriber or block until
+ * one is available. A timeout can be used to return when no message has been
+ * delivered.
+ */
+natsStatus
+natsSubscription_NextMsg(natsMsg **nextMsg, natsSubscription *sub, int64_t timeout)
+{
+    natsStatus      s    = NATS_OK;
+    natsConnection  *nc  = NULL;
+    natsMsg         *msg = NULL;
+    bool            removeSub = false;
+
+    if ((sub == NULL) || (nextMsg == NULL))
+        return nats_setDefaultError(NATS_INVALID_ARG);
+
+    natsSub_Lock(sub);
+
+    nc = sub->conn;
+
+    s = _waitForMsgs(sub, timeout);
     if (s == NATS_OK)
     {
-        msg = sub->msgList.head;
+        msg = natsMsgQueue_Pop(&(sub->msgQ));
         if ((msg == NULL) && sub->draining)
         {
             removeSub = true;
@@ -630,15 +1218,8 @@ natsSubscription_NextMsg(natsMsg **nextMsg, natsSubscription *sub, int64_t timeo
         }
         else
         {
-            sub->msgList.head = msg->next;
-
-            if (sub->msgList.tail == msg)
-                sub->msgList.tail = NULL;
-
-            sub->msgList.msgs--;
-            sub->msgList.bytes -= msg->dataLen;
-
-            msg->next = NULL;
+            nats_atomicDec(&(sub->pendingMsgs));
+            nats_atomicAdd(&(sub->pendingBytes), -(msg->dataLen));
 
             sub->delivered++;
             if (sub->max > 0)
@@ -649,7 +1230,7 @@ natsSubscription_NextMsg(natsMsg **nextMsg, natsSubscription *sub, int64_t timeo
                     removeSub = true;
             }
 
-            if (sub->draining && (sub->msgList.msgs == 0))
+            if (sub->draining && natsMsgQueue_IsEmpty(&(sub->msgQ)))
                 removeSub = true;
         }
     }
@@ -670,6 +1251,77 @@ natsSubscription_NextMsg(natsMsg **nextMsg, natsSubscription *sub, int64_t timeo
     return NATS_UPDATE_ERR_STACK(s);
 }
 
+natsStatus
+natsSubscription_NextMsgs(natsMsg **msgs, int maxMsgs, int *count,
+                          natsSubscription *sub, int64_t timeout)
+{
+    natsStatus      s     = NATS_OK;
+    natsConnection  *nc   = NULL;
+    natsMsg         *msg  = NULL;
+    bool            removeSub = false;
+    int             n     = 0;
+    int             bytes = 0;
+
+    if ((sub == NULL) || (msgs == NULL) || (count == NULL) || (maxMsgs <= 0))
+        return nats_setDefaultError(NATS_INVALID_ARG);
+
+    *count = 0;
+
+    natsSub_Lock(sub);
+
+    nc = sub->conn;
+
+    s = _waitForMsgs(sub, timeout);
+    if (s == NATS_OK)
+    {
+        // Do not return messages past the auto-unsubscribe max.
+        while ((n < maxMsgs)
+               && ((sub->max == 0) || (sub->delivered < sub->max))
+               && ((msg = natsMsgQueue_Pop(&(sub->msgQ))) != NULL))
+        {
+            msgs[n++] = msg;
+            bytes += msg->dataLen;
+            sub->delivered++;
+        }
+
+        if (n > 0)
+        {
+            nats_atomicAdd(&(sub->pendingMsgs), -n);
+            nats_atomicAdd(&(sub->pendingBytes), -bytes);
+
+            if ((sub->max > 0) && (sub->delivered == sub->max))
+                removeSub = true;
+
+            if (sub->draining && natsMsgQueue_IsEmpty(&(sub->msgQ)))
+                removeSub = true;
+        }
+        else if ((sub->max > 0) && (sub->delivered >= sub->max))
+        {
+            s = nats_setDefaultError(NATS_MAX_DELIVERED_MSGS);
+        }
+        else if (sub->draining)
+        {
+            removeSub = true;
+            s = NATS_TIMEOUT;
+        }
+    }
+    if (s == NATS_OK)
+        *count = n;
+
+    if (removeSub)
+        _retain(sub);
+
+    natsSub_Unlock(sub);
+
+    if (removeSub)
+    {
+        natsConn_removeSubscription(nc, sub);
+        natsSub_release(sub);
+    }
+
+    return NATS_UPDATE_ERR_STACK(s);
+}
+
 static natsStatus
 _unsubscribe(natsSubscription *sub, int max)
 {
@@ -727,6 +1379,18 @@ void
 natsSub_drain(natsSubscription *sub)
 {
     natsSub_Lock(sub);
+    if (sub->inlineDlv)
+    {
+        // This is called after the connection has been flushed, so the
+        // messages received before the UNSUB have all been delivered.
+        sub->draining = true;
+        _retain(sub);
+        natsSub_Unlock(sub);
+
+        natsConn_removeSubscription(sub->conn, sub);
+        natsSub_release(sub);
+        return;
+    }
     SUB_DLV_WORKER_LOCK(sub);
     sub->draining = true;
     if (sub->libDlvWorker != NULL)
@@ -751,7 +1415,7 @@ natsSub_drain(natsSubscription *sub)
         natsLib_msgDeliveryPostControlMsg(sub);
     }
     else
-        natsCondition_Broadcast(sub->cond);
+        _signalDelivery(sub);
     SUB_DLV_WORKER_UNLOCK(sub);
     natsSub_Unlock(sub);
 }
@@ -792,6 +1456,9 @@ natsSubscription_WaitForDrainCompletion(natsSubscription *sub, int64_t timeout)
     if (sub == NULL)
         return nats_setDefaultError(NATS_INVALID_ARG);
 
+    if (nats_isInlineDeliveryConn(sub->conn))
+        return nats_setError(NATS_ILLEGAL_STATE, "%s", INLINE_DLV_BLOCKING_ERR);
+
     natsSub_Lock(sub);
     if (!sub->draining)
     {
@@ -802,12 +1469,12 @@ natsSubscription_WaitForDrainCompletion(natsSubscription *sub, int64_t timeout)
     natsSub_Unlock(sub);
 
     if (timeout > 0)
-        deadline = nats_Now() + timeout;
+        deadline = nats_monotonicNow() + timeout;
 
     while (natsSubscription_IsValid(sub))
     {
         nats_Sleep(100);
-        if (deadline > 0 && (nats_Now() >= deadline))
+        if (deadline > 0 && (nats_monotonicNow() >= deadline))
         {
             s = nats_setError(NATS_TIMEOUT,
                     "The subscription's drain took more than the timeout of %" PRId64 "ms",
@@ -857,10 +1524,10 @@ natsSubscription_GetPending(natsSubscription *sub, int *msgs, int *bytes)
     SUB_DLV_WORKER_LOCK(sub);
 
     if (msgs != NULL)
-        *msgs = sub->msgList.msgs;
+        *msgs = nats_atomicGet(&(sub->pendingMsgs));
 
     if (bytes != NULL)
-        *bytes = sub->msgList.bytes;
+        *bytes = nats_atomicGet(&(sub->pendingBytes));
 
     SUB_DLV_WORKER_UNLOCK(sub);
 
@@ -995,10 +1662,10 @@ natsSubscription_GetMaxPending(natsSubscription *sub, int *msgs, int *bytes)
     SUB_DLV_WORKER_LOCK(sub);
 
     if (msgs != NULL)
-        *msgs = sub->msgsMax;
+        *msgs = nats_atomicGet(&(sub->msgsMax));
 
     if (bytes != NULL)
-        *bytes = sub->bytesMax;
+        *bytes = nats_atomicGet(&(sub->bytesMax));
 
     SUB_DLV_WORKER_UNLOCK(sub);
 
@@ -1007,6 +1674,20 @@ natsSubscription_GetMaxPending(natsSubscription *sub, int *msgs, int *bytes)
     return NATS_OK;
 }
 
+// The max pending counts may be raised concurrently by the thread
+// dispatching messages (see _raiseMax() in conn.c).
+static void
+_clearMax(natsAtomicInt *max)
+{
+    int cur;
+
+    do
+    {
+        cur = nats_atomicGet(max);
+    }
+    while ((cur != 0) && !nats_atomicCAS(max, cur, 0));
+}
+
 natsStatus
 natsSubscription_ClearMaxPending(natsSubscription *sub)
 {
@@ -1023,8 +1704,8 @@ natsSubscription_ClearMaxPending(natsSubscription *sub)
 
     SUB_DLV_WORKER_LOCK(sub);
 
-    sub->msgsMax = 0;
-    sub->bytesMax = 0;
+    _clearMax(&(sub->msgsMax));
+    _clearMax(&(sub->bytesMax));
 
     SUB_DLV_WORKER_UNLOCK(sub);
 
@@ -1056,16 +1737,16 @@ natsSubscription_GetStats(natsSubscription *sub,
     SUB_DLV_WORKER_LOCK(sub);
 
     if (pendingMsgs != NULL)
-        *pendingMsgs = sub->msgList.msgs;
+        *pendingMsgs = nats_atomicGet(&(sub->pendingMsgs));
 
     if (pendingBytes != NULL)
-        *pendingBytes = sub->msgList.bytes;
+        *pendingBytes = nats_atomicGet(&(sub->pendingBytes));
 
     if (maxPendingMsgs != NULL)
-        *maxPendingMsgs = sub->msgsMax;
+        *maxPendingMsgs = nats_atomicGet(&(sub->msgsMax));
 
     if (maxPendingBytes != NULL)
-        *maxPendingBytes = sub->bytesMax;
+        *maxPendingBytes = nats_atomicGet(&(sub->bytesMax));
 
     if (deliveredMsgs != NULL)
         *deliveredMsgs = (int) sub->delivered;
@@ -38,7 +38,21 @@ natsSub_release(natsSubscription *sub);
 natsStatus
 natsSub_create(natsSubscription **newSub, natsConnection *nc, const char *subj,
                const char *queueGroup, int64_t timeout, natsMsgHandler cb, void *cbClosure,
-               bool noLibDlvPool);
+               natsMsgBatchHandler batchCb, int maxBatch, int64_t linger,
+               int lanes, natsParallelOrder order, natsMsgKeyHandler keyCb,
+               bool inlineDlv, bool noLibDlvPool);
+
+// Assigns the messages (linked through their 'next' field) to the lanes of
+// a parallel subscription ordered by subject or key, and pushes them to the
+// lanes' queues. Called from the connection's reading thread.
+void
+natsSub_dispatchToLanes(natsSubscription *sub, natsMsg *head);
+
+// Invokes the callback of an inline subscription for each of the messages
+// (linked through their 'next' field). Called from the connection's reading
+// thread, without any lock held.
+void
+natsSub_deliverInline(natsSubscription *sub, natsMsg *head);
 
 void
 natsSub_setMax(natsSubscription *sub, uint64_t max);
@@ -0,0 +1,306 @@
+// Copyright 2020 The NATS Authors
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "natsp.h"
+
+#include <string.h>
+
+#include "mem.h"
+#include "sub.h"
+#include "subtable.h"
+
+// Something retired when the reader was not in the table (even sequence),
+// or since which the reader has left the table, can be reclaimed.
+#define _canReclaim(retSeq, curSeq) \
+    ((((retSeq) & 1) == 0) || ((retSeq) != (curSeq)))
+
+natsStatus
+natsSubTable_Create(natsSubTable **newTable)
+{
+    natsSubTable *t = NULL;
+
+    t = (natsSubTable*) NATS_CALLOC(1, sizeof(natsSubTable));
+    if (t == NULL)
+        return nats_setDefaultError(NATS_NO_MEMORY);
+
+    *newTable = t;
+
+    return NATS_OK;
+}
+
+static void
+_retireMem(natsSubTable *t, natsSubTableMem *mem)
+{
+    // This is a full memory barrier, so the reader, if it enters the
+    // table after this point, will not see the unlinked memory.
+    mem->seq  = nats_atomicGet(&(t->readerSeq));
+    mem->next = t->retiredMem;
+
+    t->retiredMem = mem;
+}
+
+static natsStatus
+_growDir(natsSubTable *t, int64_t pageIdx)
+{
+    natsSubTableDir *dir    = t->dir;
+    natsSubTableDir *newDir = NULL;
+    int64_t         size    = NATS_SUBTABLE_MIN_DIR_SIZE;
+
+    if (dir != NULL)
+        size = dir->size * 2;
+
+    while (size <= pageIdx)
+        size *= 2;
+
+    newDir = (natsSubTableDir*) NATS_CALLOC(1, sizeof(natsSubTableDir)
+                                    + (size_t) (size - 1) * sizeof(natsSubTablePage*));
+    if (newDir == NULL)
+        return nats_setDefaultError(NATS_NO_MEMORY);
+
+    newDir->size = size;
+
+    if (dir != NULL)
+    {
+        memcpy((void*) newDir->pages, (void*) dir->pages,
+               (size_t) dir->size * sizeof(natsSubTablePage*));
+    }
+
+    // The reader may still be using the old directory, whose pages are
+    // now shared with the new one.
+    (void) nats_atomicCASPtr(&(t->dir), dir, newDir);
+
+    if (dir != NULL)
+        _retireMem(t, &(dir->retired));
+
+    return NATS_OK;
+}
+
+natsStatus
+natsSubTable_Set(natsSubTable *t, natsSubscription *sub)
+{
+    natsStatus          s       = NATS_OK;
+    int64_t             pageIdx = (sub->sid >> NATS_SUBTABLE_PAGE_SHIFT);
+    natsSubTablePage    *page   = NULL;
+    natsSubscription    *oldSub = NULL;
+
+    if (sub->sid < 0)
+        return nats_setDefaultError(NATS_INVALID_ARG);
+
+    if ((t->dir == NULL) || (pageIdx >= t->dir->size))
+        s = _growDir(t, pageIdx);
+
+    if (s != NATS_OK)
+        return NATS_UPDATE_ERR_STACK(s);
+
+    page = t->dir->pages[pageIdx];
+    if (page == NULL)
+    {
+        page = (natsSubTablePage*) NATS_CALLOC(1, sizeof(natsSubTablePage));
+        if (page == NULL)
+            return nats_setDefaultError(NATS_NO_MEMORY);
+
+        (void) nats_atomicCASPtr(&(t->dir->pages[pageIdx]), NULL, page);
+    }
+
+    oldSub = page->subs[sub->sid & NATS_SUBTABLE_PAGE_MASK];
+    if (oldSub == sub)
+        return NATS_OK;
+
+    natsSub_retain(sub);
+
+    // The CAS makes the subscription's content visible to the reader
+    // before the subscription itself.
+    if (oldSub == NULL)
+    {
+        (void) nats_atomicCASPtr(&(page->subs[sub->sid & NATS_SUBTABLE_PAGE_MASK]),
+                                 NULL, sub);
+        page->count++;
+        t->count++;
+    }
+    else
+    {
+        (void) nats_atomicCASPtr(&(page->subs[sub->sid & NATS_SUBTABLE_PAGE_MASK]),
+                                 oldSub, sub);
+
+        oldSub->retiredSeq  = nats_atomicGet(&(t->readerSeq));
+        oldSub->retiredNext = t->retiredSubs;
+        t->retiredSubs      = oldSub;
+    }
+
+    if (sub->sid > t->maxSid)
+        t->maxSid = sub->sid;
+
+    natsSubTable_Reclaim(t);
+
+    return NATS_OK;
+}
+
+natsSubscription*
+natsSubTable_Get(natsSubTable *t, int64_t sid)
+{
+    natsSubTableDir     *dir    = t->dir;
+    natsSubTablePage    *page   = NULL;
+    int64_t             pageIdx = (sid >> NATS_SUBTABLE_PAGE_SHIFT);
+
+    if ((dir == NULL) || (sid < 0) || (pageIdx >= dir->size))
+        return NULL;
+
+    page = dir->pages[pageIdx];
+    if (page == NULL)
+        return NULL;
+
+    return page->subs[sid & NATS_SUBTABLE_PAGE_MASK];
+}
+
+void
+natsSubTable_Remove(natsSubTable *t, int64_t sid)
+{
+    natsSubTableDir     *dir    = t->dir;
+    natsSubTablePage    *page   = NULL;
+    natsSubscription    *sub    = NULL;
+    int64_t             pageIdx = (sid >> NATS_SUBTABLE_PAGE_SHIFT);
+
+    if ((dir == NULL) || (sid < 0) || (pageIdx >= dir->size))
+        return;
+
+    page = dir->pages[pageIdx];
+    if (page == NULL)
+        return;
+
+    sub = page->subs[sid & NATS_SUBTABLE_PAGE_MASK];
+    if (sub == NULL)
+        return;
+
+    (void) nats_atomicCASPtr(&(page->subs[sid & NATS_SUBTABLE_PAGE_MASK]), sub, NULL);
+
+    sub->retiredSeq  = nats_atomicGet(&(t->readerSeq));
+    sub->retiredNext = t->retiredSubs;
+    t->retiredSubs   = sub;
+
+    page->count--;
+    t->count--;
+
+    // Free pages that become empty, except the one where new sids are
+    // being assigned, which would otherwise be freed and reallocated when
+    // subscriptions are added and removed in sequence.
+    if ((page->count == 0) && (pageIdx != (t->maxSid >> NATS_SUBTABLE_PAGE_SHIFT)))
+    {
+        (void) nats_atomicCASPtr(&(dir->pages[pageIdx]), page, NULL);
+        _retireMem(t, &(page->retired));
+    }
+
+    natsSubTable_Reclaim(t);
+}
+
+void
+natsSubTable_EnterRead(natsSubTable *t)
+{
+    // This is a full memory barrier, so the reader does not look at
+    // the table before the sequence is seen as odd by the writers.
+    (void) nats_atomicInc(&(t->readerSeq));
+}
+
+void
+natsSubTable_ExitRead(natsSubTable *t)
+{
+    (void) nats_atomicInc(&(t->readerSeq));
+}
+
+void
+natsSubTable_Reclaim(natsSubTable *t)
+{
+    natsSubTableMem     *mem        = NULL;
+    natsSubTableMem     *nextMem    = NULL;
+    natsSubTableMem     *keepMem    = NULL;
+    natsSubscription    *sub        = NULL;
+    natsSubscription    *nextSub    = NULL;
+    natsSubscription    *keepSubs   = NULL;
+    natsSubscription    *relSubs    = NULL;
+    int                 seq;
+
+    if (!natsSubTable_HasRetired(t))
+        return;
+
+    // This is read after the items have been added to the lists, so if
+    // the reader leaves the table after this point, it will see them
+    // and call this function again.
+    seq = nats_atomicGet(&(t->readerSeq));
+
+    for (mem = t->retiredMem; mem != NULL; mem = nextMem)
+    {
+        nextMem = mem->next;
+
+        if (_canReclaim(mem->seq, seq))
+        {
+            NATS_FREE(mem);
+        }
+        else
+        {
+            mem->next = keepMem;
+            keepMem   = mem;
+        }
+    }
+    t->retiredMem = keepMem;
+
+    for (sub = t->retiredSubs; sub != NULL; sub = nextSub)
+    {
+        nextSub = sub->retiredNext;
+
+        if (_canReclaim(sub->retiredSeq, seq))
+        {
+            sub->retiredNext = relSubs;
+            relSubs          = sub;
+        }
+        else
+        {
+            sub->retiredNext = keepSubs;
+            keepSubs         = sub;
+        }
+    }
+    t->retiredSubs = keepSubs;
+
+    // Release only after the lists have been updated.
+    for (sub = relSubs; sub != NULL; sub = nextSub)
+    {
+        nextSub = sub->retiredNext;
+        sub->retiredNext = NULL;
+
+        natsSub_release(sub);
+    }
+}
+
+void
+natsSubTable_Destroy(natsSubTable *t)
+{
+    natsSubTableMem *mem;
+    int64_t         i;
+
+    if (t == NULL)
+        return;
+
+    if (t->dir != NULL)
+    {
+        for (i=0; i<t->dir->size; i++)
+            NATS_FREE(t->dir->pages[i]);
+
+        NATS_FREE(t->dir);
+    }
+
+    while ((mem = t->retiredMem) != NULL)
+    {
+        t->retiredMem = mem->next;
+        NATS_FREE(mem);
+    }
+
+    NATS_FREE(t);
+}
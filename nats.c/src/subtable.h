@@ -0,0 +1,118 @@
+// Copyright 2020 The NATS Authors
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SUBTABLE_H_
+#define SUBTABLE_H_
+
+#include "nats.h"
+
+// Subscription ids are assigned sequentially, so the table is an array of
+// pages of 2^NATS_SUBTABLE_PAGE_SHIFT slots, indexed by the sid.
+#define NATS_SUBTABLE_PAGE_SHIFT    (10)
+#define NATS_SUBTABLE_PAGE_SIZE     (1 << NATS_SUBTABLE_PAGE_SHIFT)
+#define NATS_SUBTABLE_PAGE_MASK     (NATS_SUBTABLE_PAGE_SIZE - 1)
+
+// Initial number of page pointers in the directory.
+#define NATS_SUBTABLE_MIN_DIR_SIZE  (8)
+
+// Memory that has been unlinked from the table but can't be freed until
+// the reader is done with it.
+typedef struct __natsSubTableMem
+{
+    struct __natsSubTableMem    *next;
+    int                         seq;
+
+} natsSubTableMem;
+
+typedef struct __natsSubTablePage
+{
+    natsSubTableMem             retired;
+    int                         count;
+    natsSubscription * volatile subs[NATS_SUBTABLE_PAGE_SIZE];
+
+} natsSubTablePage;
+
+typedef struct __natsSubTableDir
+{
+    natsSubTableMem             retired;
+    int64_t                     size;
+    natsSubTablePage * volatile pages[1];
+
+} natsSubTableDir;
+
+// A sid-indexed table of subscriptions that can be read without any lock
+// by a single reader (the connection's read loop), while it is modified
+// by other threads. Modifications must be serialized by the caller.
+//
+// The reader brackets its lookups with natsSubTable_EnterRead() and
+// natsSubTable_ExitRead(), which increment 'readerSeq' (it is odd while
+// the reader is using the table). Pages, directories and the table's
+// reference on subscriptions that are removed are not freed while the
+// reader may still see them: they are retired with the value of
+// 'readerSeq' at that time, and reclaimed once this value has changed.
+typedef struct __natsSubTable
+{
+    natsSubTableDir * volatile  dir;
+    natsAtomicInt               readerSeq;
+
+    natsSubTableMem * volatile  retiredMem;
+    natsSubscription * volatile retiredSubs;
+
+    int64_t                     count;
+    int64_t                     maxSid;
+
+} natsSubTable;
+
+#define natsSubTable_Count(t)   ((t)->count)
+
+// Returns true if some memory or subscriptions are waiting to be reclaimed.
+#define natsSubTable_HasRetired(t) \
+    (((t)->retiredMem != NULL) || ((t)->retiredSubs != NULL))
+
+natsStatus
+natsSubTable_Create(natsSubTable **newTable);
+
+// Adds the subscription at the index of its sid. The table holds a
+// reference on the subscription until it is removed.
+natsStatus
+natsSubTable_Set(natsSubTable *t, natsSubscription *sub);
+
+// Returns the subscription for this sid, or NULL if not found. This is
+// called by the reader, between natsSubTable_EnterRead() and
+// natsSubTable_ExitRead(), and does not require any lock.
+natsSubscription*
+natsSubTable_Get(natsSubTable *t, int64_t sid);
+
+// Removes the subscription for this sid, if any. The table's reference
+// on the subscription is released when the reader can no longer use it.
+void
+natsSubTable_Remove(natsSubTable *t, int64_t sid);
+
+void
+natsSubTable_EnterRead(natsSubTable *t);
+
+void
+natsSubTable_ExitRead(natsSubTable *t);
+
+// Frees the memory and releases the subscriptions that the reader can no
+// longer use. This must be called with the same lock that serializes
+// modifications.
+void
+natsSubTable_Reclaim(natsSubTable *t);
+
+// Frees the table. There must be no reader and all subscriptions must
+// have been removed and reclaimed.
+void
+natsSubTable_Destroy(natsSubTable *t);
+
+#endif /* SUBTABLE_H_ */
@@ -15,6 +15,8 @@
 #include "mem.h"
 #include "util.h"
 
+#include <string.h>
+
 static void
 _freeTimer(natsTimer *t)
 {
@@ -58,6 +60,8 @@ natsTimer_Create(natsTimer **timer, natsTimerCb timerCb, natsTimerStopCb stopCb,
     s = natsMutex_Create(&(t->mu));
     if (s == NATS_OK)
     {
+        nats_assignTimer(t);
+
         // Doing so, so that nats_resetTimer() does not try to remove the timer
         // from the list (since it is new it would not be there!).
         t->stopped = true;
@@ -95,3 +99,261 @@ natsTimer_Destroy(natsTimer *timer)
     nats_stopTimer(timer);
     natsTimer_Release(timer);
 }
+
+void
+natsTimerWheel_Init(natsTimerWheel *w, int64_t now)
+{
+    memset(w, 0, sizeof(natsTimerWheel));
+    w->tick = now;
+}
+
+static void
+_linkTimer(natsTimerWheel *w, natsTimer *t, natsTimer **list, int level, int slot)
+{
+    t->prev = NULL;
+    t->next = *list;
+    if (*list != NULL)
+        (*list)->prev = t;
+    *list = t;
+
+    t->list  = list;
+    t->level = level;
+    t->slot  = slot;
+
+    if (level >= 0)
+        w->used[level][slot / 64] |= ((uint64_t) 1 << (slot % 64));
+}
+
+static void
+_unlinkTimer(natsTimerWheel *w, natsTimer *t)
+{
+    if (t->prev != NULL)
+        t->prev->next = t->next;
+    else
+        *(t->list) = t->next;
+    if (t->next != NULL)
+        t->next->prev = t->prev;
+
+    if ((*(t->list) == NULL) && (t->level >= 0))
+        w->used[t->level][t->slot / 64] &= ~((uint64_t) 1 << (t->slot % 64));
+
+    t->prev = NULL;
+    t->next = NULL;
+    t->list = NULL;
+}
+
+// Puts the timer in the slot of the lowest level that can hold its time,
+// relative to the wheel's current tick.
+static void
+_addTimer(natsTimerWheel *w, natsTimer *t)
+{
+    int64_t when  = t->absoluteTime;
+    int     level = 0;
+    int     shift = 0;
+    int     slot;
+
+    if (when < w->tick)
+        when = w->tick;
+
+    for (;;)
+    {
+        shift = level * NATS_TIMER_WHEEL_BITS;
+
+        if (((when >> shift) - (w->tick >> shift)) < NATS_TIMER_WHEEL_SLOTS)
+            break;
+
+        if (level == NATS_TIMER_WHEEL_LEVELS - 1)
+        {
+            when = ((w->tick >> shift) + NATS_TIMER_WHEEL_SLOTS - 1) << shift;
+            break;
+        }
+        level++;
+    }
+
+    slot = (int) ((when >> shift) & NATS_TIMER_WHEEL_MASK);
+
+    _linkTimer(w, t, &(w->slots[level][slot]), level, slot);
+}
+
+void
+natsTimerWheel_Add(natsTimerWheel *w, natsTimer *t)
+{
+    _addTimer(w, t);
+    w->count++;
+}
+
+void
+natsTimerWheel_Remove(natsTimerWheel *w, natsTimer *t)
+{
+    if (t->list == NULL)
+        return;
+
+    _unlinkTimer(w, t);
+    w->count--;
+}
+
+// Returns the distance from the slot `from` to the first non-empty slot
+// of a level (possibly `from` itself), or -1 if all slots are empty.
+static int
+_firstUsed(const uint64_t *used, int from)
+{
+    uint64_t    bits;
+    int         off = 0;
+    int         i;
+
+    while (off < NATS_TIMER_WHEEL_SLOTS)
+    {
+        i    = (from + off) & NATS_TIMER_WHEEL_MASK;
+        bits = used[i / 64] >> (i % 64);
+
+        if (bits == 0)
+        {
+            off += 64 - (i % 64);
+            continue;
+        }
+        while ((bits & 1) == 0)
+        {
+            bits >>= 1;
+            off++;
+        }
+        return (off < NATS_TIMER_WHEEL_SLOTS ? off : -1);
+    }
+    return -1;
+}
+
+bool
+natsTimerWheel_NextTick(natsTimerWheel *w, int64_t *next)
+{
+    bool    found = false;
+    int64_t best  = 0;
+    int64_t base;
+    int64_t tick;
+    int     level;
+    int     shift;
+    int     off;
+
+    if (w->expired != NULL)
+    {
+        *next = w->tick - 1;
+        return true;
+    }
+    if (w->count == 0)
+        return false;
+
+    for (level = 0; level < NATS_TIMER_WHEEL_LEVELS; level++)
+    {
+        shift = level * NATS_TIMER_WHEEL_BITS;
+
+        // Slots of the upper levels are moved down when the tick reaches
+        // their start, so look from the first slot that starts at or after
+        // the current tick.
+        base = ((w->tick - 1) >> shift) + 1;
+
+        off = _firstUsed(w->used[level], (int) (base & NATS_TIMER_WHEEL_MASK));
+        if (off < 0)
+            continue;
+
+        tick = (base + off) << shift;
+        if (!found || (tick < best))
+        {
+            best  = tick;
+            found = true;
+        }
+    }
+    if (found)
+        *next = best;
+
+    return found;
+}
+
+// Moves down the upper levels' slots that are reached at `tick` and
+// moves the timers of that tick to the expired list.
+static void
+_processTick(natsTimerWheel *w, int64_t tick)
+{
+    natsTimer   *list;
+    natsTimer   *t;
+    int         level;
+    int         shift;
+    int         slot;
+
+    w->tick = tick;
+
+    for (level = NATS_TIMER_WHEEL_LEVELS - 1; level > 0; level--)
+    {
+        shift = level * NATS_TIMER_WHEEL_BITS;
+        if ((tick & (((int64_t) 1 << shift) - 1)) != 0)
+            continue;
+
+        slot = (int) ((tick >> shift) & NATS_TIMER_WHEEL_MASK);
+        list = w->slots[level][slot];
+
+        w->slots[level][slot] = NULL;
+        w->used[level][slot / 64] &= ~((uint64_t) 1 << (slot % 64));
+
+        while ((t = list) != NULL)
+        {
+            list = t->next;
+            _addTimer(w, t);
+        }
+    }
+
+    slot = (int) (tick & NATS_TIMER_WHEEL_MASK);
+
+    w->expired = w->slots[0][slot];
+    w->slots[0][slot] = NULL;
+    w->used[0][slot / 64] &= ~((uint64_t) 1 << (slot % 64));
+
+    for (t = w->expired; t != NULL; t = t->next)
+    {
+        t->list  = &(w->expired);
+        t->level = -1;
+    }
+
+    w->tick = tick + 1;
+}
+
+natsTimer*
+natsTimerWheel_PopExpired(natsTimerWheel *w, int64_t now)
+{
+    natsTimer   *t;
+    int64_t     next;
+
+    for (;;)
+    {
+        if ((t = w->expired) != NULL)
+        {
+            _unlinkTimer(w, t);
+            w->count--;
+            return t;
+        }
+        if (!natsTimerWheel_NextTick(w, &next) || (next > now))
+        {
+            // Nothing happens until after `now`, so the ticks up to it
+            // can be skipped.
+            if (now >= w->tick)
+                w->tick = now + 1;
+
+            return NULL;
+        }
+        _processTick(w, next);
+    }
+}
+
+natsTimer*
+natsTimerWheel_First(natsTimerWheel *w)
+{
+    int level;
+    int slot;
+
+    if (w->expired != NULL)
+        return w->expired;
+
+    for (level = 0; (w->count > 0) && (level < NATS_TIMER_WHEEL_LEVELS); level++)
+    {
+        slot = _firstUsed(w->used[level], 0);
+        if (slot >= 0)
+            return w->slots[level][slot];
+    }
+    return NULL;
+}
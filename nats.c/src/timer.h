@@ -20,6 +20,7 @@
 #include "status.h"
 
 struct __natsTimer;
+struct __natsLibTimers;
 
 // Callback signature for timer
 typedef void (*natsTimerCb)(struct __natsTimer *timer, void* closure);
@@ -33,6 +34,15 @@ typedef struct __natsTimer
     struct __natsTimer  *prev;
     struct __natsTimer  *next;
 
+    // Timer thread this timer is assigned to.
+    struct __natsLibTimers  *owner;
+
+    // Wheel list the timer is in (NULL if none), and its position in the
+    // wheel (level is -1 for the list of expired timers).
+    struct __natsTimer  **list;
+    int                 level;
+    int                 slot;
+
     natsMutex           *mu;
     int                 refs;
 
@@ -48,6 +58,36 @@ typedef struct __natsTimer
 
 } natsTimer;
 
+// The timers are kept in a hierarchical timing wheel with a granularity
+// of one millisecond. Each level has 256 slots, a slot of a level covering
+// a full revolution of the level below, so that 4 levels cover about 49
+// days. Timers further away than that are put in the last slot of the top
+// level and moved down when that slot is reached.
+#define NATS_TIMER_WHEEL_BITS   (8)
+#define NATS_TIMER_WHEEL_SLOTS  (1 << NATS_TIMER_WHEEL_BITS)
+#define NATS_TIMER_WHEEL_MASK   (NATS_TIMER_WHEEL_SLOTS - 1)
+#define NATS_TIMER_WHEEL_LEVELS (4)
+#define NATS_TIMER_WHEEL_WORDS  (NATS_TIMER_WHEEL_SLOTS / 64)
+
+typedef struct __natsTimerWheel
+{
+    // Next tick (in milliseconds) to be processed.
+    int64_t             tick;
+
+    // Number of timers in the wheel, including the expired ones.
+    int                 count;
+
+    natsTimer           *slots[NATS_TIMER_WHEEL_LEVELS][NATS_TIMER_WHEEL_SLOTS];
+
+    // Bitmap of the non-empty slots, used to find the next tick without
+    // walking the slots.
+    uint64_t            used[NATS_TIMER_WHEEL_LEVELS][NATS_TIMER_WHEEL_WORDS];
+
+    // Timers of the last processed tick that have not been returned yet.
+    natsTimer           *expired;
+
+} natsTimerWheel;
+
 natsStatus
 natsTimer_Create(natsTimer **timer, natsTimerCb timerCb, natsTimerStopCb stopCb,
                  int64_t interval, void* closure);
@@ -64,5 +104,30 @@ natsTimer_Release(natsTimer *t);
 void
 natsTimer_Destroy(natsTimer *timer);
 
+void
+natsTimerWheel_Init(natsTimerWheel *w, int64_t now);
+
+// Adds the timer to the wheel, at its absolute time.
+void
+natsTimerWheel_Add(natsTimerWheel *w, natsTimer *t);
+
+// Removes the timer from the wheel, if it is in it.
+void
+natsTimerWheel_Remove(natsTimerWheel *w, natsTimer *t);
+
+// Returns false if the wheel is empty, otherwise sets `next` to the time
+// at which the wheel needs to be processed.
+bool
+natsTimerWheel_NextTick(natsTimerWheel *w, int64_t *next);
+
+// Removes and returns a timer whose absolute time is at or before `now`,
+// or NULL if there is none.
+natsTimer*
+natsTimerWheel_PopExpired(natsTimerWheel *w, int64_t now);
+
+// Returns any timer from the wheel, or NULL if it is empty.
+natsTimer*
+natsTimerWheel_First(natsTimerWheel *w);
+
 
 #endif /* TIMER_H_ */
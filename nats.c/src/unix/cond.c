@@ -27,8 +27,23 @@ natsCondition_Create(natsCondition **cond)
     if (c == NULL)
         return nats_setDefaultError(NATS_NO_MEMORY);
 
+#if defined(NATS_MONOTONIC_CLOCK) && !defined(__APPLE__)
+    {
+        pthread_condattr_t attr;
+
+        // Timed waits are based on nats_monotonicNow().
+        if ((pthread_condattr_init(&attr) != 0)
+            || (pthread_condattr_setclock(&attr, NATS_MONOTONIC_CLOCK) != 0)
+            || (pthread_cond_init(c, &attr) != 0))
+        {
+            s = nats_setError(NATS_SYS_ERROR, "pthread_cond_init error: %d", errno);
+        }
+        pthread_condattr_destroy(&attr);
+    }
+#else
     if (pthread_cond_init(c, NULL) != 0)
         s = nats_setError(NATS_SYS_ERROR, "pthread_cond_init error: %d", errno);
+#endif
 
     if (s == NATS_OK)
         *cond = c;
@@ -55,7 +70,16 @@ _timedWait(natsCondition *cond, natsMutex *mutex, bool isAbsolute, int64_t timeo
     if (timeout <= 0)
         return NATS_TIMEOUT;
 
-    target = (isAbsolute ? timeout : (nats_Now() + timeout));
+#if defined(__APPLE__)
+    // The clock of the condition variable cannot be changed, but the wait
+    // can be given a relative time, which is not affected by changes of the
+    // system clock.
+    target = (isAbsolute ? (timeout - nats_monotonicNow()) : timeout);
+    if (target <= 0)
+        return NATS_TIMEOUT;
+#else
+    target = (isAbsolute ? timeout : (nats_monotonicNow() + timeout));
+#endif
 
     ts.tv_sec = target / 1000;
     ts.tv_nsec = (target % 1000) * 1000000;
@@ -66,7 +90,11 @@ _timedWait(natsCondition *cond, natsMutex *mutex, bool isAbsolute, int64_t timeo
         ts.tv_nsec -= 1000000000L;
     }
 
+#if defined(__APPLE__)
+    r = pthread_cond_timedwait_relative_np(cond, mutex, &ts);
+#else
     r = pthread_cond_timedwait(cond, mutex, &ts);
+#endif
 
     if (r == 0)
         return NATS_OK;
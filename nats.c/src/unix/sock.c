@@ -101,3 +101,20 @@ natsSock_Flush(natsSock fd)
 
     return NATS_OK;
 }
+
+int
+natsSock_SendV(natsSock fd, natsIOVec *iov, int iovcnt)
+{
+    struct msghdr msg;
+
+    memset(&msg, 0, sizeof(msg));
+
+    msg.msg_iov    = iov;
+    msg.msg_iovlen = (iovcnt > NATS_SOCK_IOV_MAX ? NATS_SOCK_IOV_MAX : iovcnt);
+
+#ifdef MSG_NOSIGNAL
+    return (int) sendmsg(fd, &msg, MSG_NOSIGNAL);
+#else
+    return (int) sendmsg(fd, &msg, 0);
+#endif
+}
@@ -56,7 +56,7 @@ natsCondition_TimedWait(natsCondition *cond, natsMutex *mutex, int64_t timeout)
 natsStatus
 natsCondition_AbsoluteTimedWait(natsCondition *cond, natsMutex *mutex, int64_t absoluteTime)
 {
-    int64_t now = nats_Now();;
+    int64_t now = nats_monotonicNow();
     int64_t sleepTime = absoluteTime - now;
 
     if (sleepTime <= 0)
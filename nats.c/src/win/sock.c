@@ -150,3 +150,25 @@ natsSock_Flush(natsSock fd)
 
     return NATS_OK;
 }
+
+int
+natsSock_SendV(natsSock fd, natsIOVec *iov, int iovcnt)
+{
+    WSABUF  bufs[NATS_SOCK_IOV_MAX];
+    DWORD   sent = 0;
+    int     i;
+
+    if (iovcnt > NATS_SOCK_IOV_MAX)
+        iovcnt = NATS_SOCK_IOV_MAX;
+
+    for (i=0; i<iovcnt; i++)
+    {
+        bufs[i].buf = (char*) iov[i].iov_base;
+        bufs[i].len = (ULONG) iov[i].iov_len;
+    }
+
+    if (WSASend(fd, bufs, (DWORD) iovcnt, &sent, 0, NULL, NULL) == SOCKET_ERROR)
+        return NATS_SOCK_ERROR;
+
+    return (int) sent;
+}